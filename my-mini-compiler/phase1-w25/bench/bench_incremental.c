@@ -0,0 +1,166 @@
+/* bench_incremental.c
+ * Benchmark: latency of lex_update() for single-character edits against lexing the whole
+ * text again, on a text of 50k+ lines. The line index follows every edit too, and both are
+ * checked against a full lex and a full index now and then.
+ *
+ * Usage: bench_incremental [FILE] [edits]
+ * Without FILE the correct test input is repeated until it is at least 50000 lines long.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tokens.h"
+#include "lexer.h"
+#include "source.h"
+#include "token_stream.h"
+#include "incremental.h"
+#include "lines.h"
+
+#define SYNTHETIC_LINES 50000
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static size_t count_lines(const char *text, size_t length) {
+    size_t lines = 1;
+    for (size_t i = 0; i < length; i++) {
+        lines += text[i] == '\n';
+    }
+    return lines;
+}
+
+// Repeat the correct test input until it has SYNTHETIC_LINES lines
+static char *synthetic_input(size_t *length, size_t *capacity) {
+    const char *path = "../phase1-w25/test/input_correct_lex.txt";
+    SourceFile source;
+    if (source_open(&source, path) != 0) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return NULL;
+    }
+    size_t per_copy = count_lines(source.data, source.length);
+    size_t copies = SYNTHETIC_LINES / per_copy + 1;
+    *capacity = copies * (source.length + 1) + 64;
+    char *buffer = malloc(*capacity);
+    size_t fill = 0;
+    for (size_t c = 0; buffer != NULL && c < copies; c++) {
+        memcpy(buffer + fill, source.data, source.length);
+        fill += source.length;
+        buffer[fill++] = '\n';
+    }
+    if (buffer != NULL) {
+        buffer[fill] = '\0';
+    }
+    source_close(&source);
+    *length = fill;
+    return buffer;
+}
+
+static int same_streams(const TokenStream *a, const TokenStream *b) {
+    return a->count == b->count &&
+           memcmp(a->kinds, b->kinds, a->count) == 0 &&
+           memcmp(a->errors, b->errors, a->count) == 0 &&
+           memcmp(a->flags, b->flags, a->count) == 0 &&
+           memcmp(a->starts, b->starts, a->count * sizeof(uint32_t)) == 0 &&
+           memcmp(a->lengths, b->lengths, a->count * sizeof(uint32_t)) == 0 &&
+           memcmp(a->values, b->values, a->count * sizeof(uint64_t)) == 0;
+}
+
+static int same_lines(const LineIndex *a, const LineIndex *b) {
+    return a->count == b->count && memcmp(a->starts, b->starts, a->count * sizeof(uint32_t)) == 0;
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : NULL;
+    int edits = argc > 2 ? atoi(argv[2]) : 2000;
+    size_t length, capacity;
+    char *text;
+
+    if (path != NULL) {
+        SourceFile source;
+        if (source_open(&source, path) != 0) {
+            fprintf(stderr, "cannot open %s\n", path);
+            return 1;
+        }
+        length = source.length;
+        capacity = length + 64;
+        text = malloc(capacity);
+        if (text != NULL) {
+            memcpy(text, source.data, length + 1);
+        }
+        source_close(&source);
+    } else {
+        text = synthetic_input(&length, &capacity);
+    }
+    if (text == NULL) {
+        return 1;
+    }
+
+    LexerOptions quiet = {0};
+    TokenStream tokens;
+    LineIndex lines;
+    double t0 = now_seconds();
+    if (lex_all(text, length, &quiet, &tokens) != 0 || line_index_build(&lines, text, length) != 0) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    double full = now_seconds() - t0;
+
+    // alternate typing a character into the text and deleting it again
+    double total = 0, worst = 0;
+    size_t changed = 0;
+    unsigned int seed = 12345;
+    for (int e = 0; e < edits; e++) {
+        seed = seed * 1103515245u + 12345u;
+        LexEdit edit = {(seed >> 8) % length, 0, 1};
+        char typed = "a1 ;(+\n"[(seed >> 4) % 7];
+        memmove(text + edit.offset + 1, text + edit.offset, length - edit.offset + 1);
+        text[edit.offset] = typed;
+        length++;
+
+        for (int undo = 0; undo < 2; undo++) {
+            LexChange change;
+            double start = now_seconds();
+            if (lex_update(&tokens, text, length, &edit, &quiet, &change) != 0 ||
+                line_index_edit(&lines, text, length, edit.offset, edit.deleted, edit.inserted) != 0) {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+            }
+            double took = now_seconds() - start;
+            total += took;
+            worst = took > worst ? took : worst;
+            changed += change.new_end - change.first;
+
+            if (undo == 0) {
+                memmove(text + edit.offset, text + edit.offset + 1, length - edit.offset);
+                length--;
+                edit.deleted = 1;
+                edit.inserted = 0;
+            }
+        }
+        if (e % 100 == 0) {
+            TokenStream check;
+            LineIndex check_lines;
+            if (lex_all(text, length, &quiet, &check) != 0 || !same_streams(&tokens, &check) ||
+                line_index_build(&check_lines, text, length) != 0 || !same_lines(&lines, &check_lines)) {
+                fprintf(stderr, "MISMATCH after edit %d\n", e);
+                return 1;
+            }
+            token_stream_free(&check);
+            line_index_free(&check_lines);
+        }
+    }
+
+    printf("%zu lines, %zu tokens\n", lines.count, tokens.count);
+    printf("full lex:     %10.3f ms (with the line index)\n", full * 1e3);
+    printf("lex_update:   %10.3f ms mean, %.3f ms worst, %.1f tokens changed per edit\n",
+           total * 1e3 / (2.0 * edits), worst * 1e3, (double)changed / (2.0 * edits));
+
+    token_stream_free(&tokens);
+    line_index_free(&lines);
+    free(text);
+    return 0;
+}
@@ -0,0 +1,91 @@
+/* bench_keywords.c
+ * Microbenchmark: perfect-hash keyword lookup against the old linear strcmp scan.
+ *
+ * Usage: bench_keywords [iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "keywords.h"
+
+// The recognizer iskeyword() used before the generated hash, kept as the baseline
+static int iskeyword_linear(const char *token) {
+    for (int i = 0; i < NUM_KEYWORDS; i++) {
+        if (strcmp(token, keywords[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Identifier-heavy mix: roughly one keyword for every three identifiers
+static const char *samples[] = {
+    "x", "y", "i", "count", "total", "celebrate", "notAKeyword", "theTab",
+    "buffer_size", "while", "if", "int", "return_value", "print", "integer",
+    "united", "for", "index", "string", "strings", "float_value", "double",
+    "node", "next", "prev", "until", "flag", "_tmp", "char", "hi2", "false",
+    "truth", "value", "func", "key", "else", "length", "switcher", "void"
+};
+
+#define NUM_SAMPLES ((int)(sizeof(samples) / sizeof(samples[0])))
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 2000000;
+    size_t lengths[NUM_SAMPLES];
+    unsigned int hashes[NUM_SAMPLES];
+
+    // both recognizers must agree before timing means anything
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        if (iskeyword(samples[i]) != iskeyword_linear(samples[i])) {
+            fprintf(stderr, "mismatch on '%s'\n", samples[i]);
+            return 1;
+        }
+        lengths[i] = strlen(samples[i]);
+        hashes[i] = KEYWORD_HASH_INIT;
+        for (size_t j = 0; j < lengths[i]; j++) {
+            hashes[i] = KEYWORD_HASH_STEP(hashes[i], samples[i][j]);
+        }
+    }
+
+    long lookups = iterations * NUM_SAMPLES;
+    volatile long sink = 0;
+
+    double start = now_seconds();
+    for (long n = 0; n < iterations; n++) {
+        for (int i = 0; i < NUM_SAMPLES; i++) {
+            sink += iskeyword_linear(samples[i]);
+        }
+    }
+    double linear = now_seconds() - start;
+
+    // iskeyword() hashes from scratch, like a caller holding only a C string
+    start = now_seconds();
+    for (long n = 0; n < iterations; n++) {
+        for (int i = 0; i < NUM_SAMPLES; i++) {
+            sink += iskeyword(samples[i]);
+        }
+    }
+    double hashed = now_seconds() - start;
+
+    // keyword_lookup() with the hash already built during scanning, like the lexer
+    start = now_seconds();
+    for (long n = 0; n < iterations; n++) {
+        for (int i = 0; i < NUM_SAMPLES; i++) {
+            sink += keyword_lookup(samples[i], lengths[i], hashes[i]);
+        }
+    }
+    double fused = now_seconds() - start;
+
+    printf("%ld lookups (%d samples x %ld iterations)\n", lookups, NUM_SAMPLES, iterations);
+    printf("linear strcmp scan : %8.2f ns/lookup\n", linear * 1e9 / (double)lookups);
+    printf("iskeyword (hash)   : %8.2f ns/lookup  (%.1fx)\n", hashed * 1e9 / (double)lookups, linear / hashed);
+    printf("keyword_lookup     : %8.2f ns/lookup  (%.1fx)\n", fused * 1e9 / (double)lookups, linear / fused);
+    return 0;
+}
@@ -0,0 +1,99 @@
+/* bench_lexer.c
+ * Benchmark: get_next_token() throughput over whole files, usually corpora from gen_corpus.
+ * Every file is lexed warm-up times untimed, then timed over the repetitions; the report
+ * gives the mean with its standard deviation and the best and worst run.
+ *
+ * Usage: bench_lexer [--warmup N] [--reps N] FILE...
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tokens.h"
+#include "lexer.h"
+#include "source.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Lex the whole input once; returns the number of tokens, EOF included */
+static size_t lex_once(const char *input, size_t length) {
+    LexerOptions quiet = {0};
+    Lexer lexer;
+    lexer_init(&lexer, input, length, &quiet);
+    size_t count = 0;
+    Token token;
+    do {
+        token = get_next_token(&lexer);
+        count++;
+    } while (token.type != TOKEN_EOF);
+    return count;
+}
+
+static const char *base_name(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash != NULL ? slash + 1 : path;
+}
+
+int main(int argc, char **argv) {
+    int warmup = 1, reps = 5, files = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        } else {
+            argv[++files] = argv[i];
+        }
+    }
+    if (files == 0 || reps < 1) {
+        fprintf(stderr, "usage: %s [--warmup N] [--reps N] FILE...\n", argv[0]);
+        return 1;
+    }
+
+    double *times = malloc((size_t)reps * sizeof(double));
+    if (times == NULL) {
+        return 1;
+    }
+    printf("%-24s %10s %12s %9s %9s %12s %9s %9s %9s\n", "input", "MiB", "tokens", "MB/s", "+-%",
+           "tokens/s", "ns/token", "best", "worst");
+    for (int f = 1; f <= files; f++) {
+        SourceFile source;
+        if (source_open(&source, argv[f]) != 0) {
+            fprintf(stderr, "cannot open %s\n", argv[f]);
+            continue;
+        }
+
+        size_t tokens = 0;
+        for (int w = 0; w < warmup; w++) {
+            tokens = lex_once(source.data, source.length);
+        }
+        double mean = 0;
+        for (int r = 0; r < reps; r++) {
+            double start = now_seconds();
+            tokens = lex_once(source.data, source.length);
+            times[r] = now_seconds() - start;
+            mean += times[r];
+        }
+        mean /= reps;
+        double variance = 0, best = times[0], worst = times[0];
+        for (int r = 0; r < reps; r++) {
+            variance += (times[r] - mean) * (times[r] - mean);
+            best = times[r] < best ? times[r] : best;
+            worst = times[r] > worst ? times[r] : worst;
+        }
+        variance = reps > 1 ? variance / (reps - 1) : 0;
+
+        double mib = (double)source.length / (1024.0 * 1024.0);
+        printf("%-24s %10.1f %12zu %9.1f %9.1f %12.3e %9.2f %9.1f %9.1f\n", base_name(argv[f]), mib,
+               tokens, mib / mean, 100.0 * sqrt(variance) / mean, (double)tokens / mean,
+               mean * 1e9 / (double)tokens, mib / best, mib / worst);
+        source_close(&source);
+    }
+    free(times);
+    return 0;
+}
@@ -0,0 +1,186 @@
+/* bench_operators.c
+ * Benchmark: operator recognition on expression-dense input, where about a third of the
+ * tokens are operators. Compares the switch-based recognizer the lexer used to have, a walk
+ * through the scanner DFA and the three-byte operator table, then times the whole lexer.
+ *
+ * Usage: bench_operators [megabytes]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tokens.h"
+#include "lexer.h"
+#include "scanner_tables.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static const char *operators[] = {
+    "+", "-", "*", "/", "%", "=", "==", "!=", "+=", "-=", "*=", "/=", "%=", "++", "--",
+    "<", ">", "<=", ">=", "<<", ">>", "<<<", ">>>", "||", "^", "^^", "|", "&&", "&?", "$", "!"
+};
+#define NUM_OPERATORS ((int)(sizeof(operators) / sizeof(operators[0])))
+
+// Statements like "v12 += (a3 <<< 2) * b7 ^^ c1;": operand, operator, operand, ...
+static char *expression_input(size_t size, size_t *length) {
+    char *buffer = malloc(size + 64);
+    size_t fill = 0;
+    unsigned int seed = 12345;
+    while (buffer != NULL && fill < size) {
+        int terms = 2 + (int)((seed = seed * 1103515245u + 12345u) >> 16) % 5;
+        for (int t = 0; t < terms; t++) {
+            seed = seed * 1103515245u + 12345u;
+            unsigned int r = seed >> 16;
+            if (r % 4 == 0) {
+                fill += (size_t)sprintf(buffer + fill, "%u", r % 1000);
+            } else {
+                fill += (size_t)sprintf(buffer + fill, "%c%u", 'a' + r % 26, r % 100);
+            }
+            const char *op = t == terms - 1 ? ";\n" : operators[(r >> 8) % NUM_OPERATORS];
+            fill += (size_t)sprintf(buffer + fill, " %s ", op);
+        }
+    }
+    if (buffer != NULL) {
+        buffer[fill] = '\0';
+    }
+    *length = fill;
+    return buffer;
+}
+
+// The operator switch get_next_token() had before the generated tables
+static size_t switch_length(const char *p) {
+    char c = p[0], c_next = p[1];
+    switch (c) {
+        case '+':
+        case '-':
+            return c_next == '=' || c_next == c ? 2 : 1;
+        case '*':
+        case '/':
+        case '%':
+        case '=':
+        case '!':
+            return c_next == '=' ? 2 : 1;
+        case '|':
+        case '^':
+            return c_next == c ? 2 : 1;
+        case '&':
+            return c_next == c || c_next == '?' ? 2 : 0;
+        case '<':
+        case '>':
+            if (c_next == c) {
+                return p[2] == c ? 3 : 2;
+            }
+            return c_next == '=' ? 2 : 1;
+        case '$':
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static size_t dfa_length(const char *p) {
+    const unsigned char *q = (const unsigned char *)p;
+    unsigned int state = SCAN_START, next;
+    while ((next = scan_next[state][scan_class[*q]]) != 0) {
+        state = next;
+        q++;
+    }
+    return (size_t)((const char *)q - p);
+}
+
+static size_t table_length(const char *p) {
+    unsigned int first = scan_op_class[(unsigned char)p[0]];
+    unsigned int second = scan_op_class[(unsigned char)p[1]];
+    unsigned int third = p[1] != '\0' ? scan_op_class[(unsigned char)p[2]] : 0;
+    unsigned int op = scan_op[(first * SCAN_OP_CLASSES + second) * SCAN_OP_CLASSES + third];
+    return op != 0 ? scan_rules[op - 1].length : 0;
+}
+
+typedef size_t (*Recognizer)(const char *p);
+
+static double time_recognizer(Recognizer recognize, const char *input, const size_t *starts,
+                              size_t count, int repetitions, size_t *sum) {
+    double best = 0;
+    for (int r = 0; r < repetitions; r++) {
+        size_t total = 0;
+        double start = now_seconds();
+        for (size_t i = 0; i < count; i++) {
+            total += recognize(input + starts[i]);
+        }
+        double elapsed = now_seconds() - start;
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+        *sum = total;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    size_t megabytes = argc > 1 ? (size_t)atol(argv[1]) : 16;
+    int repetitions = 5;
+    size_t length;
+    char *input = expression_input(megabytes * 1024 * 1024, &length);
+    if (input == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    // full lexer, collecting the operator positions on the way
+    LexerOptions quiet = {0};
+    Lexer lexer;
+    size_t capacity = 1 << 20, count = 0, tokens = 0;  // operator positions are kept from round 0
+    size_t *starts = malloc(capacity * sizeof(size_t));
+    double best = 0;
+    for (int r = 0; r < repetitions; r++) {
+        lexer_init(&lexer, input, length, &quiet);
+        tokens = 0;
+        double start = now_seconds();
+        Token token;
+        do {
+            token = get_next_token(&lexer);
+            tokens++;
+            if (token.type == TOKEN_OPERATOR && r == 0) {
+                if (count == capacity) {
+                    capacity *= 2;
+                    starts = realloc(starts, capacity * sizeof(size_t));
+                }
+                starts[count++] = token.start;
+            }
+        } while (token.type != TOKEN_EOF);
+        double elapsed = now_seconds() - start;
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    printf("%zu bytes, %zu tokens, %zu operators (%.0f%%)\n", length, tokens, count,
+           100.0 * (double)count / (double)tokens);
+    printf("lexer       %8.1f MB/s  %6.1f ns/token\n", (double)length / best / 1e6,
+           best * 1e9 / (double)tokens);
+
+    // the recognizers alone, at every operator position
+    size_t expected, sum;
+    double switch_time = time_recognizer(switch_length, input, starts, count, repetitions, &expected);
+    double dfa_time = time_recognizer(dfa_length, input, starts, count, repetitions, &sum);
+    int status = 0;
+    if (sum != expected) {
+        fprintf(stderr, "DFA disagrees with the switch\n");
+        status = 1;
+    }
+    double table_time = time_recognizer(table_length, input, starts, count, repetitions, &sum);
+    if (sum != expected) {
+        fprintf(stderr, "operator table disagrees with the switch\n");
+        status = 1;
+    }
+    printf("switch      %8.2f ns/operator\n", switch_time * 1e9 / (double)count);
+    printf("DFA         %8.2f ns/operator\n", dfa_time * 1e9 / (double)count);
+    printf("table       %8.2f ns/operator\n", table_time * 1e9 / (double)count);
+
+    free(starts);
+    free(input);
+    return status;
+}
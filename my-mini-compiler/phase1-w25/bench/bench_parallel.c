@@ -0,0 +1,138 @@
+/* bench_parallel.c
+ * Benchmark: parallel lexing of one buffer at 1 to 16 threads against the sequential lexer.
+ *
+ * Usage: bench_parallel [FILE] [repetitions]
+ * Without FILE the correct test input is repeated into a buffer of about 64 MiB. (The
+ * incorrect one ends inside an unterminated string, so every copy would flip which quotes
+ * open strings and leave no boundary in a state the speculation can find.)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tokens.h"
+#include "lexer.h"
+#include "parallel.h"
+#include "source.h"
+
+#define SYNTHETIC_SIZE (64u * 1024 * 1024)
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int same_token(const Token *a, const Token *b) {
+    return a->type == b->type && a->error == b->error && a->flags == b->flags && a->start == b->start &&
+           a->length == b->length && a->value.integer == b->value.integer;
+}
+
+// Repeat the correct test input until the buffer is full
+static char *synthetic_input(size_t *length) {
+    const char *path = "../phase1-w25/test/input_correct_lex.txt";
+    SourceFile source;
+    if (source_open(&source, path) != 0) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return NULL;
+    }
+    char *buffer = malloc(SYNTHETIC_SIZE + 1);
+    size_t fill = 0;
+    while (buffer != NULL && fill + source.length + 1 <= SYNTHETIC_SIZE) {
+        memcpy(buffer + fill, source.data, source.length);
+        fill += source.length;
+        buffer[fill++] = '\n';
+    }
+    if (buffer != NULL) {
+        buffer[fill] = '\0';
+    }
+    source_close(&source);
+    *length = fill;
+    return buffer;
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : NULL;
+    int repetitions = argc > 2 ? atoi(argv[2]) : 5;
+    SourceFile source = {0};
+    char *synthetic = NULL;
+    const char *input;
+    size_t length;
+
+    if (path != NULL) {
+        if (source_open(&source, path) != 0) {
+            fprintf(stderr, "cannot open %s\n", path);
+            return 1;
+        }
+        input = source.data;
+        length = source.length;
+    } else {
+        synthetic = synthetic_input(&length);
+        if (synthetic == NULL) {
+            return 1;
+        }
+        input = synthetic;
+    }
+
+    // sequential baseline, also the reference every parallel run must reproduce
+    LexerOptions quiet = {0};
+    Lexer lexer;
+    size_t capacity = 1024, count = 0;
+    Token *expected = malloc(capacity * sizeof(Token));
+    double best = 0;
+    for (int r = 0; r < repetitions; r++) {
+        lexer_init(&lexer, input, length, &quiet);
+        count = 0;
+        double start = now_seconds();
+        Token token;
+        do {
+            token = get_next_token(&lexer);
+            if (count == capacity) {
+                capacity *= 2;
+                expected = realloc(expected, capacity * sizeof(Token));
+            }
+            expected[count++] = token;
+        } while (token.type != TOKEN_EOF);
+        double elapsed = now_seconds() - start;
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    double sequential = best;
+    printf("%zu bytes, %zu tokens\n", length, count);
+    printf("sequential  %8.1f MB/s\n", (double)length / sequential / 1e6);
+
+    int status = 0;
+    for (int threads = 1; threads <= 16; threads *= 2) {
+        for (int r = 0; r < repetitions; r++) {
+            TokenList list;
+            double start = now_seconds();
+            if (lex_parallel(input, length, threads, &list) != 0) {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+            }
+            double elapsed = now_seconds() - start;
+            if (r == 0 || elapsed < best) {
+                best = elapsed;
+            }
+            int same = list.count == count;
+            for (size_t i = 0; same && i < count; i++) {
+                same = same_token(&list.tokens[i], &expected[i]);
+            }
+            if (!same) {
+                fprintf(stderr, "%d threads: token stream differs from sequential\n", threads);
+                status = 1;
+            }
+            token_list_free(&list);
+        }
+        printf("%2d threads  %8.1f MB/s  %5.2fx\n", threads,
+               (double)length / best / 1e6, sequential / best);
+    }
+
+    free(expected);
+    free(synthetic);
+    if (path != NULL) {
+        source_close(&source);
+    }
+    return status;
+}
@@ -0,0 +1,105 @@
+/* bench_token_iter.c
+ * Benchmark: a parser-like loop that looks K tokens ahead before taking each token, done
+ * with get_next_token() on a copy of the lexer (re-lexing the lookahead every time) against
+ * a TokenIter ring.
+ *
+ * Usage: bench_token_iter FILE [K] [repetitions]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "tokens.h"
+#include "lexer.h"
+#include "source.h"
+#include "token_iter.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// What a parser written against get_next_token() does to look ahead: lex from a copy
+static unsigned long long relex_lookahead(const char *input, size_t length, size_t k, size_t *count) {
+    LexerOptions quiet = {0};
+    Lexer lexer;
+    lexer_init(&lexer, input, length, &quiet);
+    unsigned long long sum = 0;
+    size_t n = 0;
+    Token token;
+    do {
+        Lexer ahead = lexer;
+        for (size_t i = 0; i < k; i++) {
+            Token next = get_next_token(&ahead);
+            sum += (unsigned long long)next.type * (i + 1) + next.start;
+        }
+        token = get_next_token(&lexer);
+        sum += token.length;
+        n++;
+    } while (token.type != TOKEN_EOF);
+    *count = n;
+    return sum;
+}
+
+static unsigned long long iter_lookahead(const char *input, size_t length, size_t k, size_t *count) {
+    LexerOptions quiet = {0};
+    TokenIter iter;
+    if (token_iter_init(&iter, input, length, k, &quiet) != 0) {
+        return 0;
+    }
+    unsigned long long sum = 0;
+    size_t n = 0;
+    Token token;
+    do {
+        for (size_t i = 0; i < k; i++) {
+            const Token *next = token_iter_peek(&iter, i);
+            sum += (unsigned long long)next->type * (i + 1) + next->start;
+        }
+        token = token_iter_next(&iter);
+        sum += token.length;
+        n++;
+    } while (token.type != TOKEN_EOF);
+    token_iter_free(&iter);
+    *count = n;
+    return sum;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s FILE [K] [repetitions]\n", argv[0]);
+        return 1;
+    }
+    size_t k = argc > 2 ? (size_t)atoi(argv[2]) : 2;
+    int repetitions = argc > 3 ? atoi(argv[3]) : 5;
+    SourceFile source;
+    if (source_open(&source, argv[1]) != 0) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    double best_relex = 1e30, best_iter = 1e30;
+    size_t count = 0, iter_count = 0;
+    for (int r = 0; r < repetitions; r++) {
+        double t0 = now_seconds();
+        unsigned long long relex_sum = relex_lookahead(source.data, source.length, k, &count);
+        double t1 = now_seconds();
+        unsigned long long iter_sum = iter_lookahead(source.data, source.length, k, &iter_count);
+        double t2 = now_seconds();
+        if (relex_sum != iter_sum || count != iter_count) {
+            fprintf(stderr, "MISMATCH: %zu tokens against %zu\n", iter_count, count);
+            return 1;
+        }
+        best_relex = t1 - t0 < best_relex ? t1 - t0 : best_relex;
+        best_iter = t2 - t1 < best_iter ? t2 - t1 : best_iter;
+    }
+
+    double mb = (double)source.length / (1024.0 * 1024.0);
+    printf("%.1f MiB, %zu tokens, lookahead %zu, best of %d\n", mb, count, k, repetitions);
+    printf("%-28s %8.1f MB/s %8.2f ns/token\n", "get_next_token, re-lexing",
+           mb / best_relex, best_relex * 1e9 / (double)count);
+    printf("%-28s %8.1f MB/s %8.2f ns/token\n", "TokenIter ring",
+           mb / best_iter, best_iter * 1e9 / (double)count);
+
+    source_close(&source);
+    return 0;
+}
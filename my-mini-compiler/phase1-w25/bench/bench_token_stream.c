@@ -0,0 +1,173 @@
+/* bench_token_stream.c
+ * Benchmark: lexing a buffer into a Token array with get_next_token() against lex_all()
+ * into a TokenStream, then a pass over the result that only reads kinds and starts, and
+ * pairing up the brackets of the TokenStream.
+ *
+ * Usage: bench_token_stream [FILE] [repetitions]
+ * Without FILE the correct test input is repeated into a buffer of about 256 MiB.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tokens.h"
+#include "lexer.h"
+#include "source.h"
+#include "token_stream.h"
+#include "brackets.h"
+
+#define SYNTHETIC_SIZE (256u * 1024 * 1024)
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Repeat the correct test input until the buffer is full
+static char *synthetic_input(size_t *length) {
+    const char *path = "../phase1-w25/test/input_correct_lex.txt";
+    SourceFile source;
+    if (source_open(&source, path) != 0) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return NULL;
+    }
+    char *buffer = malloc(SYNTHETIC_SIZE + 1);
+    size_t fill = 0;
+    while (buffer != NULL && fill + source.length + 1 <= SYNTHETIC_SIZE) {
+        memcpy(buffer + fill, source.data, source.length);
+        fill += source.length;
+        buffer[fill++] = '\n';
+    }
+    if (buffer != NULL) {
+        buffer[fill] = '\0';
+    }
+    source_close(&source);
+    *length = fill;
+    return buffer;
+}
+
+// The get_next_token() loop a caller collecting every token would write
+static Token *lex_tokens(const char *input, size_t length, size_t *count) {
+    LexerOptions quiet = {0};
+    Lexer lexer;
+    size_t capacity = length / 4 + 64, n = 0;
+    Token *tokens = malloc(capacity * sizeof(Token));
+    lexer_init(&lexer, input, length, &quiet);
+    do {
+        if (n == capacity) {
+            capacity *= 2;
+            tokens = realloc(tokens, capacity * sizeof(Token));
+        }
+        if (tokens == NULL) {
+            return NULL;
+        }
+        tokens[n] = get_next_token(&lexer);
+    } while (tokens[n++].type != TOKEN_EOF);
+    *count = n;
+    return tokens;
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : NULL;
+    int repetitions = argc > 2 ? atoi(argv[2]) : 5;
+    SourceFile source = {0};
+    char *synthetic = NULL;
+    const char *input;
+    size_t length;
+
+    if (path != NULL) {
+        if (source_open(&source, path) != 0) {
+            fprintf(stderr, "cannot open %s\n", path);
+            return 1;
+        }
+        input = source.data;
+        length = source.length;
+    } else {
+        synthetic = synthetic_input(&length);
+        if (synthetic == NULL) {
+            return 1;
+        }
+        input = synthetic;
+    }
+
+    LexerOptions quiet = {0};
+    double best_array = 1e30, best_stream = 1e30, best_array_pass = 1e30, best_stream_pass = 1e30;
+    double best_brackets = 1e30;
+    size_t count = 0;
+    for (int r = 0; r < repetitions; r++) {
+        double t0 = now_seconds();
+        Token *tokens = lex_tokens(input, length, &count);
+        double t1 = now_seconds();
+        TokenStream stream;
+        if (tokens == NULL || lex_all(input, length, &quiet, &stream) != 0) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        double t2 = now_seconds();
+
+        if (stream.count != count) {
+            fprintf(stderr, "MISMATCH: %zu tokens against %zu\n", stream.count, count);
+            return 1;
+        }
+        for (size_t i = 0; i < count; i++) {
+            Token token = token_stream_get(&stream, i);
+            if (token.type != tokens[i].type || token.error != tokens[i].error ||
+                token.start != tokens[i].start || token.length != tokens[i].length) {
+                fprintf(stderr, "MISMATCH at token %zu\n", i);
+                return 1;
+            }
+        }
+
+        // where the identifiers are: a pass that never looks at lengths or symbols
+        double t3 = now_seconds();
+        unsigned long long array_sum = 0, stream_sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (tokens[i].type == TOKEN_IDENTIFIER) {
+                array_sum += (unsigned long long)tokens[i].start;
+            }
+        }
+        double t4 = now_seconds();
+        for (size_t i = 0; i < count; i++) {
+            if (stream.kinds[i] == TOKEN_IDENTIFIER) {
+                stream_sum += stream.starts[i];
+            }
+        }
+        double t5 = now_seconds();
+        if (array_sum != stream_sum) {
+            fprintf(stderr, "MISMATCH in the identifier pass\n");
+            return 1;
+        }
+        BracketIndex brackets;
+        if (bracket_index_build(&brackets, &stream, input) != 0) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        double t6 = now_seconds();
+        bracket_index_free(&brackets);
+
+        best_array = t1 - t0 < best_array ? t1 - t0 : best_array;
+        best_stream = t2 - t1 < best_stream ? t2 - t1 : best_stream;
+        best_array_pass = t4 - t3 < best_array_pass ? t4 - t3 : best_array_pass;
+        best_stream_pass = t5 - t4 < best_stream_pass ? t5 - t4 : best_stream_pass;
+        best_brackets = t6 - t5 < best_brackets ? t6 - t5 : best_brackets;
+        free(tokens);
+        token_stream_free(&stream);
+    }
+
+    double mb = (double)length / (1024.0 * 1024.0);
+    printf("%.1f MiB, %zu tokens, best of %d\n", mb, count, repetitions);
+    printf("%-28s %8.1f MB/s %8.2f ns/token\n", "get_next_token into Token[]",
+           mb / best_array, best_array * 1e9 / (double)count);
+    printf("%-28s %8.1f MB/s %8.2f ns/token\n", "lex_all into TokenStream",
+           mb / best_stream, best_stream * 1e9 / (double)count);
+    printf("%-28s %8.2f ns/token\n", "kind/start pass, Token[]", best_array_pass * 1e9 / (double)count);
+    printf("%-28s %8.2f ns/token\n", "kind/start pass, TokenStream", best_stream_pass * 1e9 / (double)count);
+    printf("%-28s %8.2f ns/token\n", "bracket index, TokenStream", best_brackets * 1e9 / (double)count);
+
+    free(synthetic);
+    if (path != NULL) {
+        source_close(&source);
+    }
+    return 0;
+}
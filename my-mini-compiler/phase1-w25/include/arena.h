@@ -0,0 +1,26 @@
+/* arena.h */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+/* Bump allocator for data that lives as long as a lexed source, such as decoded string
+ * literals: allocations come out of large blocks and are only ever freed all at once.
+ */
+typedef struct {
+    ArenaBlock *blocks;     // the block being filled, linked to the ones before it
+    char *next;             // free space in it
+    char *end;
+} Arena;
+
+void arena_init(Arena *arena);
+
+/* size bytes, aligned for any type. Returns NULL when out of memory */
+void *arena_alloc(Arena *arena, size_t size);
+
+/* Free everything allocated from the arena; it can be used again afterwards */
+void arena_free(Arena *arena);
+
+#endif /* ARENA_H */
@@ -0,0 +1,55 @@
+/* batch.h */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include "emit.h"
+#include "stats.h"
+
+/* One input of a batch run */
+typedef struct {
+    char *path;
+    char *title;            // name printed in the "Analyzing" header
+    size_t size;            // bytes, for scheduling the largest files first
+    char *output;           // everything emitted for the file, until it is written out
+    size_t output_length;
+    int failed;             // the file could not be read
+    int taken;              // a worker has started on it
+    int done;
+} BatchFile;
+
+/* Files to lex, in the order their output is written */
+typedef struct {
+    BatchFile *files;
+    size_t count;
+    size_t capacity;
+} Batch;
+
+void batch_init(Batch *batch);
+
+/* Add one file; title NULL uses the path. Returns 0, or -1 when out of memory */
+int batch_add_file(Batch *batch, const char *path, const char *title);
+
+/* Add a file, or every file under a directory (sorted by name, hidden entries skipped).
+ * Returns 0, or -1 when the path cannot be read */
+int batch_add_path(Batch *batch, const char *path);
+
+/* Add the paths listed one per line in list_path ("-" for stdin), each as batch_add_path() */
+int batch_add_list(Batch *batch, const char *list_path);
+
+/* Output of finished files held back for an earlier one, past which workers stop running ahead */
+#define BATCH_PENDING_LIMIT ((size_t)64 << 20)
+
+/* Lex every file on threads worker threads (0 for one per core) and emit their output to out,
+ * in out's format and in the order the files were added, whatever order they finish in.
+ * Workers take the largest files first and steal from each other when they run dry. Once
+ * BATCH_PENDING_LIMIT bytes of output wait for an earlier file, they take files in the order
+ * they are written instead, so what is held stays near that plus one file per worker.
+ * With stats, every worker counts into its own LexStats and the counts are added to stats.
+ * Returns the number of files that could not be read, or -1 when out of memory.
+ */
+int batch_run(Batch *batch, int threads, Emitter *out, LexStats *stats);
+
+void batch_free(Batch *batch);
+
+#endif /* BATCH_H */
@@ -0,0 +1,73 @@
+/* brackets.h */
+#ifndef BRACKETS_H
+#define BRACKETS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "token_stream.h"
+
+/* Partner of a token that is not a bracket, or of one left unbalanced */
+#define BRACKET_NONE UINT32_MAX
+
+/* An opening bracket waiting for its closing one */
+typedef struct {
+    uint64_t start;         // offset of the bracket
+    uint32_t token;         // its token index, for a BracketIndex
+    uint32_t line;          // where it is, for reporting it unclosed
+    uint32_t column;
+    char bracket;           // '(', '[' or '{'
+} OpenBracket;
+
+/* The brackets still open, innermost last, fed the bracket tokens in order with
+ * bracket_stack_match() */
+typedef struct {
+    OpenBracket *open;
+    size_t depth;
+    size_t capacity;
+} BracketStack;
+
+static inline int bracket_opens(char c) {
+    return c == '(' || c == '[' || c == '{';
+}
+
+static inline int bracket_closes(char c) {
+    return c == ')' || c == ']' || c == '}';
+}
+
+void bracket_stack_init(BracketStack *stack);
+
+/* What bracket_stack_match() did with a bracket */
+typedef enum {
+    BRACKET_OPENED,         // pushed
+    BRACKET_MATCHED,        // closed the innermost open bracket of its kind
+    BRACKET_UNMATCHED,      // a closing one with no open bracket of its kind; stack unchanged
+    BRACKET_FAILED          // out of memory
+} BracketMatch;
+
+/* The matching step, shared by bracket_index_build() and the emitter: push an opening bracket,
+ * or pair a closing one with the innermost open bracket of its kind. When MATCHED, that partner
+ * is popped to open[depth] and the *unclosed brackets it leaves open inside the pair follow it
+ * in open[depth + 1 ...], innermost last, until the next push */
+BracketMatch bracket_stack_match(BracketStack *stack, const OpenBracket *bracket, size_t *unclosed);
+
+void bracket_stack_free(BracketStack *stack);
+
+/* Matching brackets of a token stream: the parser jumps over a whole block by going from
+ * an opening bracket's index to its partner's */
+typedef struct {
+    uint32_t *partners;     // partners[i]: the token bracket i pairs with, else BRACKET_NONE
+    size_t count;           // tokens
+    uint32_t *unbalanced;   // brackets left unclosed or unmatched, in token order
+    size_t unbalanced_count;
+} BracketIndex;
+
+/* Pair up the brackets of tokens, lexed from input. Returns 0, or -1 when out of memory */
+int bracket_index_build(BracketIndex *index, const TokenStream *tokens, const char *input);
+
+static inline uint32_t bracket_partner(const BracketIndex *index, size_t token) {
+    return index->partners[token];
+}
+
+void bracket_index_free(BracketIndex *index);
+
+#endif /* BRACKETS_H */
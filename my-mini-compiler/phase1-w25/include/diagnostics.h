@@ -0,0 +1,48 @@
+/* diagnostics.h */
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "tokens.h"
+#include "lines.h"
+
+/* One lexical error, kept until the output for its input is finished */
+typedef struct {
+    uint64_t start;         // offset of the error token
+    uint32_t length;
+    uint32_t kind;          // ErrorType
+    uint32_t line;          // where it is, resolved when it was recorded (the streaming
+    uint32_t column;        // lexer's window may have moved on by the time it is printed)
+} Diagnostic;
+
+/* Errors collected while lexing, instead of being printed between the tokens.
+ * At most max_errors are kept; the ones after that are only counted.
+ */
+typedef struct {
+    Diagnostic *items;
+    size_t count;           // kept
+    size_t capacity;
+    size_t max_errors;      // 0 for no limit
+    size_t total;           // seen, kept or not
+} Diagnostics;
+
+void diagnostics_init(Diagnostics *diagnostics, size_t max_errors);
+
+/* Record an error token at pos. Returns 0, or -1 when out of memory (it is then only counted) */
+int diagnostics_add(Diagnostics *diagnostics, const Token *token, LinePos pos);
+
+/* Put the kept errors in source order */
+void diagnostics_sort(Diagnostics *diagnostics);
+
+/* Errors seen but not kept */
+static inline size_t diagnostics_dropped(const Diagnostics *diagnostics) {
+    return diagnostics->total - diagnostics->count;
+}
+
+/* Forget the errors recorded so far, keeping the limit and the memory */
+void diagnostics_clear(Diagnostics *diagnostics);
+
+void diagnostics_free(Diagnostics *diagnostics);
+
+#endif /* DIAGNOSTICS_H */
@@ -0,0 +1,92 @@
+/* emit.h */
+#ifndef EMIT_H
+#define EMIT_H
+
+#include <stddef.h>
+#include "tokens.h"
+#include "lines.h"
+#include "diagnostics.h"
+#include "brackets.h"
+
+/* Output formats */
+typedef enum {
+    EMIT_TEXT,      // "Token: TYPE | Lexeme: '...' | Line: N", the original format
+    EMIT_JSON,      // one JSON object per line
+    EMIT_CSV        // file,type,error,lexeme,line,column,start,length,value with a header row
+} EmitFormat;
+
+/* Buffered token writer. Records are formatted straight into a large block with hand-rolled
+ * number and escape writers and written out with write(2) whenever the block fills up.
+ * With fd -1 nothing is written and the buffer keeps growing, for output that is collected
+ * in memory (the batch driver's per-file output).
+ */
+typedef struct {
+    EmitFormat format;
+    int echo;               // include the source text in file headers (text and JSON)
+    int fd;                 // where blocks go, -1 to keep everything in buffer
+    char *buffer;
+    size_t size;
+    size_t capacity;
+    char *scratch;          // decoded lexeme before escaping
+    size_t scratch_capacity;
+    const char *title;      // current file, for the CSV file column
+    const LineIndex *lines; // line index of the current file, for emit_token()
+    size_t line_hint;       // line of the last token emitted, where the next lookup starts
+    int header_done;        // CSV header row written
+    int failed;             // out of memory or a write failed
+    int defer_errors;       // record error tokens in diagnostics instead of writing them in place
+    Diagnostics diagnostics;
+    BracketStack brackets;  // brackets of the current file still open
+} Emitter;
+
+/* Returns 0, or -1 when out of memory */
+int emitter_init(Emitter *emitter, int fd, EmitFormat format, int echo);
+
+/* A new emitter collecting into memory with the same format and settings as config */
+int emitter_init_like(Emitter *emitter, const Emitter *config);
+
+/* Hold back lexical errors: emit_token() records them, up to max_errors of them (0 for all),
+ * and emit_diagnostics() writes them out once the file's tokens are done */
+void emitter_defer_errors(Emitter *emitter, size_t max_errors);
+
+/* "text", "json" or "csv". Returns 0, or -1 for an unknown name */
+int emit_parse_format(const char *name, EmitFormat *format);
+
+/* Start the output: the CSV header row, nothing in the other formats. The first record
+ * emitted does this too; call it when the records are copied in with emit_raw() */
+void emit_begin(Emitter *emitter);
+
+/* Start the output for a file: the "Analyzing" header, echoing source when enabled */
+void emit_file_header(Emitter *emitter, const char *title, const char *source, size_t length);
+
+/* Report a file that could not be opened */
+void emit_open_error(Emitter *emitter, const char *title);
+
+/* One token; input is the buffer its offsets refer to and emitter->lines its line index.
+ * Brackets are matched up as they go by: a closing bracket without an open one of its kind
+ * is reported after it, and so are the open ones it leaves unclosed */
+void emit_token(Emitter *emitter, const char *input, const Token *token);
+
+/* The same for a token at pos whose own text starts at text, NULL when the text is no longer
+ * around (the streaming lexer's oversized tokens) */
+void emit_token_at(Emitter *emitter, const char *text, const Token *token, LinePos pos);
+
+/* Finish the current file's errors: report the brackets it left open, then write the errors
+ * held back in source order, followed by a count of those over the limit, and forget them.
+ * input is the buffer their offsets refer to, NULL when it is gone (the streaming lexer's):
+ * invalid characters and brackets held back are then reported without their text */
+void emit_diagnostics(Emitter *emitter, const char *input);
+
+/* Bytes copied to the output as they are */
+void emit_raw(Emitter *emitter, const char *data, size_t length);
+
+/* Write out everything buffered. Returns 0, or -1 if anything failed */
+int emitter_flush(Emitter *emitter);
+
+/* Hand the collected buffer to the caller (fd -1 emitters); the emitter is left empty */
+char *emitter_take(Emitter *emitter, size_t *length);
+
+/* Flush and release the emitter. Returns what emitter_flush() does */
+int emitter_close(Emitter *emitter);
+
+#endif /* EMIT_H */
@@ -0,0 +1,35 @@
+/* incremental.h */
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stddef.h>
+#include "lexer.h"
+#include "token_stream.h"
+
+/* One edit to the text: deleted bytes at offset were replaced by inserted new ones */
+typedef struct {
+    size_t offset;      // where the edit starts, the same in the old and the new text
+    size_t deleted;     // bytes of the old text removed there
+    size_t inserted;    // bytes of new text put in their place
+} LexEdit;
+
+/* What an update changed: old tokens [first, old_end) became new tokens [first, new_end).
+ * Tokens before first are untouched; the ones after moved by the edit's size but are
+ * otherwise the same. A LineIndex of the text follows the same edit with line_index_edit(). */
+typedef struct {
+    size_t first;
+    size_t old_end;
+    size_t new_end;
+} LexChange;
+
+/* Bring tokens, a lex_all() stream of the old text, up to date with input, the whole text
+ * after edit. Only the part of the text the edit can affect is lexed again: from the last
+ * token before the edit that leaves the lexer in a known state, up to the first token after
+ * the edit where the new tokens fall back in step with the old ones.
+ * options should be the ones the stream was lexed with (may be NULL).
+ * Returns 0, or -1 when out of memory or the text is too long (tokens is then unchanged).
+ */
+int lex_update(TokenStream *tokens, const char *input, size_t length, const LexEdit *edit,
+               const LexerOptions *options, LexChange *change);
+
+#endif /* INCREMENTAL_H */
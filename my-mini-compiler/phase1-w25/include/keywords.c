@@ -2,20 +2,36 @@
 #include "keywords.h"
 
 const char* keywords[NUM_KEYWORDS] = {
-    "if", "else", "switch", "case", "default",
-    "do", "while", "for", "until", "break",
-    "print", "read",
-    "int", "float", "double", "char", "bool", "string", "void",
-    "func",
-    "null", "true", "false"
+#define KEYWORD(word) word,
+#include "keywords.def"
+#undef KEYWORD
 };
 
+static const unsigned char keyword_lengths[NUM_KEYWORDS] = {
+#define KEYWORD(word) sizeof(word) - 1,
+#include "keywords.def"
+#undef KEYWORD
+};
+
+// Perfect hash table computed by gen_keywords: every keyword has its own slot
+static const signed char keyword_slots[KEYWORD_TABLE_SIZE] = KEYWORD_SLOTS_INIT;
+
+// Function to check a lexeme whose running hash was computed during scanning
+int keyword_lookup(const char* lexeme, size_t length, unsigned int hash) {
+    int slot = keyword_slots[(hash >> KEYWORD_HASH_SHIFT) & (KEYWORD_TABLE_SIZE - 1)];
+    if (slot < 0 || keyword_lengths[slot] != length) {
+        return 0;  // Not a keyword
+    }
+    // only one candidate can live in the slot, so one comparison settles it
+    return memcmp(lexeme, keywords[slot], length) == 0;
+}
+
 // Function to check if a given token is a keyword
 int iskeyword(const char* token) {
-    for (int i = 0; i < NUM_KEYWORDS; i++) {
-        if (strcmp(token, keywords[i]) == 0) {
-            return 1;  // It's a keyword
-        }
+    unsigned int hash = KEYWORD_HASH_INIT;
+    size_t length = 0;
+    for (; token[length] != '\0'; length++) {
+        hash = KEYWORD_HASH_STEP(hash, token[length]);
     }
-    return 0;  // Not a keyword
+    return keyword_lookup(token, length, hash);
 }
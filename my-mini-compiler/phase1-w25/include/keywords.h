@@ -1,10 +1,20 @@
 #ifndef KEYWORDS_H
 #define KEYWORDS_H
 
-#define NUM_KEYWORDS 23
- 
+#include <stddef.h>
+#include "keyword_hash.h"  // generated at build time by tools/gen_keywords.c
+
+#define NUM_KEYWORDS KEYWORD_COUNT  // counted from keywords.def by gen_keywords
+
 extern const char * keywords[NUM_KEYWORDS];
 
+/* Running keyword hash: start from KEYWORD_HASH_INIT and feed every character
+ * of the identifier through KEYWORD_HASH_STEP while scanning it */
+#define KEYWORD_HASH_STEP(h, c) ((h) * KEYWORD_HASH_MULT + (unsigned char)(c))
+
 int iskeyword(const char * token);
 
-#endif
\ No newline at end of file
+// Same check, for callers that already know the length and running hash of the lexeme
+int keyword_lookup(const char * lexeme, size_t length, unsigned int hash);
+
+#endif
@@ -0,0 +1,63 @@
+/* lexer.h */
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "tokens.h"
+#include "lines.h"
+#include "symbols.h"
+#include "arena.h"
+
+/* Options that change how a lexer behaves */
+typedef struct {
+    int warnings;       // print [WARN] notes (unclosed comments, ...)
+    FILE *warn_out;     // where the notes go, NULL for stdout
+    SymbolTable *symbols;   // intern identifiers here and set Token.symbol, NULL to skip
+} LexerOptions;
+
+/* Lexer context: everything get_next_token() reads or updates lives here, so any number
+ * of lexers can run side by side (one per thread, for example) without sharing state.
+ */
+typedef struct {
+    const char *input;      // NUL-terminated source buffer
+    size_t length;          // Bytes in input (without the terminator)
+    size_t pos;             // Offset of the next character to scan
+    char last_token_type;   // Class of the previous token, for checking consecutive operators
+    LexerOptions options;
+} Lexer;
+
+/* Start lexing input from the beginning. options may be NULL for the defaults */
+void lexer_init(Lexer *lexer, const char *input, size_t length, const LexerOptions *options);
+
+/* Get next token from the lexer's input */
+Token get_next_token(Lexer *lexer);
+
+/* Lex up to max tokens into tokens, stopping after TOKEN_EOF. Returns how many were lexed.
+ * The same tokens as calling get_next_token() that many times, without a call per token */
+size_t lexer_fill(Lexer *lexer, Token *tokens, size_t max);
+
+/* Whether a token (or a blank or a comment) can start at c. A run of bytes that cannot,
+ * a NUL inside the input among them, is lexed as one ERROR_INVALID_CHAR token */
+int token_can_start(char c);
+
+/* Value of a string or char literal token (without an error): its text between the quotes
+ * with escapes decoded. A literal without TOKEN_FLAG_ESCAPES is its source span, returned as
+ * it is and not NUL-terminated; any other is decoded into arena on each call, NUL-terminated.
+ * Sets *length. Returns NULL when out of memory */
+const char *token_literal(Arena *arena, const char *input, const Token *token, size_t *length);
+
+/* Print token information / lexical errors; input is the buffer the token's offsets refer to
+ * and lines its line index, for the line numbers */
+void print_token(const char *input, const LineIndex *lines, const Token *token);
+void print_error(const char *input, const LineIndex *lines, const Token *token);
+
+/* The same, printing to out instead of stdout */
+void fprint_token(FILE *out, const char *input, const LineIndex *lines, const Token *token);
+void fprint_error(FILE *out, const char *input, const LineIndex *lines, const Token *token);
+
+/* Name of a token type ("IDENTIFIER", ...) and the message for an error type */
+const char *token_type_name(TokenType type);
+const char *error_message(ErrorType error);
+
+#endif /* LEXER_H */
@@ -0,0 +1,75 @@
+/* lines.h */
+#ifndef LINES_H
+#define LINES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Where the lines of a text start, for turning token offsets into line and column numbers.
+ * Tokens only carry offsets; the index is built in one vectorized pass over the text and
+ * only looked at when a line number is printed. A line break is '\n', '\r\n' or a lone '\r'.
+ * Line first_line + i starts at offset base + starts[i]. A whole buffer has base 0 and
+ * first_line 1; the streaming lexer keeps an index of its window only (see stream.h).
+ */
+typedef struct {
+    uint32_t *starts;
+    size_t count;           // lines, at least 1
+    size_t capacity;        // 0 when starts is borrowed (tokfile_lines()) and never freed
+    size_t base;
+    size_t first_line;
+} LineIndex;
+
+/* 1-based line and column (in bytes) of an offset */
+typedef struct {
+    size_t line;
+    size_t column;
+} LinePos;
+
+/* An index of one line, line first_line starting at offset base; line_index_scan() adds the
+ * lines after it. Returns 0, or -1 when out of memory */
+int line_index_init(LineIndex *index, size_t base, size_t first_line);
+
+/* Index the lines of input. Returns 0, or -1 when out of memory or the input is longer than
+ * 32-bit offsets reach */
+int line_index_build(LineIndex *index, const char *input, size_t length);
+
+/* Add the line starts in text[0, length), where text[0] is at offset at from the index's base.
+ * A '\r' in the last byte is a line break of its own unless more is set (more text follows,
+ * which may start with its '\n'); then it is left out. Returns 0, or -1 when out of memory */
+int line_index_scan(LineIndex *index, const char *text, size_t length, size_t at, int more);
+
+/* Bring an index of the old text up to date after deleted bytes at offset were replaced by
+ * inserted ones; input is the whole new text. Only the edited bytes are scanned again.
+ * Returns 0, or -1 when out of memory (the index is then unchanged) */
+int line_index_edit(LineIndex *index, const char *input, size_t length,
+                    size_t offset, size_t deleted, size_t inserted);
+
+/* Line and column of offset. hint may be NULL; otherwise *hint is a line (index into starts)
+ * to try before searching and is set to the line found, so walking tokens in order costs a
+ * compare or two per token instead of a binary search */
+LinePos line_index_locate(const LineIndex *index, size_t offset, size_t *hint);
+
+void line_index_free(LineIndex *index);
+
+/* Line and column lookups in a text too long for a LineIndex (over 4 GiB): only a window of
+ * LINE_CURSOR_WINDOW bytes is indexed at a time, and the offsets looked up never go back */
+#define LINE_CURSOR_WINDOW ((size_t)64 << 20)
+
+typedef struct {
+    LineIndex window;       // lines from window.base up to end, window.base a line start
+    const char *input;
+    size_t length;
+    size_t end;             // offset the window is scanned up to
+    size_t hint;
+} LineCursor;
+
+/* Returns 0, or -1 when out of memory */
+int line_cursor_init(LineCursor *cursor, const char *input, size_t length);
+
+/* Line and column of offset, at or past every offset looked up before. Out of memory, or a
+ * single line longer than 4 GiB, only loses the lines past the ones found so far */
+LinePos line_cursor_locate(LineCursor *cursor, size_t offset);
+
+void line_cursor_free(LineCursor *cursor);
+
+#endif /* LINES_H */
@@ -0,0 +1,18 @@
+/* number.h */
+#ifndef NUMBER_H
+#define NUMBER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Value of the decimal digits[0, length), converted 8 digits at a time.
+ * Returns 0, or -1 when it does not fit in 64 bits */
+int parse_integer(const char *digits, size_t length, uint64_t *value);
+
+/* Value of a float literal text[0, length): digits, then an optional '.' and digits and an
+ * optional exponent (e or E, an optional sign, digits), correctly rounded to the nearest
+ * double. Returns 0, or -1 when it is too large for a double (values too small for one come
+ * out as 0) */
+int parse_float(const char *text, size_t length, double *value);
+
+#endif /* NUMBER_H */
@@ -0,0 +1,29 @@
+/* parallel.h */
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+#include "tokens.h"
+
+/* Tokens of a whole buffer, in source order, ending with the EOF token */
+typedef struct {
+    Token *tokens;
+    size_t count;
+} TokenList;
+
+/* Lex one buffer on up to threads threads.
+ * The buffer is split into ranges at line starts and every range is lexed speculatively from
+ * each state its boundary can be in: normal code, inside a string literal or inside a
+ * comment. The range results are then stitched together by matching token starts, with a
+ * short sequential re-lex wherever no speculation matches, so the tokens are exactly those of
+ * a sequential get_next_token() run ([WARN] notes are not printed).
+ * A range whose real start state is not found quickly (say a string that opens before the
+ * boundary and whose quotes stay out of step for the whole range) is lexed sequentially
+ * while stitching: still exact, only slower.
+ * Returns 0 on success, -1 when out of memory.
+ */
+int lex_parallel(const char *input, size_t length, int threads, TokenList *out);
+
+void token_list_free(TokenList *list);
+
+#endif /* PARALLEL_H */
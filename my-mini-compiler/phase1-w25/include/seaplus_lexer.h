@@ -0,0 +1,134 @@
+/* seaplus_lexer.h
+ * C API of the lexer library (libseaplus_lexer), for programs that lex in-process.
+ * This header is the whole interface: the other headers are internal to the library and
+ * can change from one version to the next, what is declared here only grows.
+ */
+#ifndef SEAPLUS_LEXER_H
+#define SEAPLUS_LEXER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define SEAPLUS_API __attribute__((visibility("default")))
+#else
+#define SEAPLUS_API
+#endif
+
+/* Raised whenever something is added below */
+#define SEAPLUS_LEXER_API_VERSION 2
+
+/* Token types. The numbers never change, new types get new numbers */
+enum {
+    SEAPLUS_TOKEN_EOF = 0,
+    SEAPLUS_TOKEN_NUMBER = 1,
+    SEAPLUS_TOKEN_OPERATOR = 2,
+    SEAPLUS_TOKEN_ERROR = 3,
+    SEAPLUS_TOKEN_KEYWORD = 4,
+    SEAPLUS_TOKEN_IDENTIFIER = 5,
+    SEAPLUS_TOKEN_STRING_LITERAL = 6,
+    SEAPLUS_TOKEN_CHAR_LITERAL = 7,
+    SEAPLUS_TOKEN_DELIMITER = 8,
+    SEAPLUS_TOKEN_SPECIAL_CHARACTER = 9,
+    SEAPLUS_TOKEN_FLOAT = 10
+};
+
+/* Lexical errors, numbered the same way */
+enum {
+    SEAPLUS_ERROR_NONE = 0,
+    SEAPLUS_ERROR_INVALID_CHAR = 1,
+    SEAPLUS_ERROR_INVALID_NUMBER = 2,
+    SEAPLUS_ERROR_CONSECUTIVE_OPERATORS = 3,
+    SEAPLUS_ERROR_STRING_OVERFLOW = 4,
+    SEAPLUS_ERROR_UNTERMINATED_STRING = 5,
+    SEAPLUS_ERROR_INVALID_ESCAPE_CHARACTER = 6,
+    SEAPLUS_ERROR_UNTERMINATED_CHARACTER = 7,
+    SEAPLUS_ERROR_OPEN_DELIMITER = 8,
+    SEAPLUS_ERROR_TOKEN_OVERFLOW = 9,
+    SEAPLUS_ERROR_UNMATCHED_DELIMITER = 10     // since version 2
+};
+
+/* SeaplusToken.flags: the literal has escapes to decode, see seaplus_lexer_literal() */
+#define SEAPLUS_FLAG_ESCAPES 0x1u
+
+typedef struct {
+    uint32_t type;          // SEAPLUS_TOKEN_*
+    uint32_t error;         // SEAPLUS_ERROR_*; a bracket left unbalanced is a
+                            // SEAPLUS_TOKEN_DELIMITER with an OPEN or UNMATCHED_DELIMITER error
+    uint64_t start;         // offset of the first byte in the lexed buffer
+    uint64_t length;        // bytes of source text
+    uint32_t line;          // 1-based
+    uint32_t column;        // 1-based, in bytes
+    uint32_t symbol;        // identifiers: an ID that is the same for the same name in every
+                            // buffer the context lexes, else 0
+    uint32_t flags;         // SEAPLUS_FLAG_* bits
+    union {
+        uint64_t integer;   // SEAPLUS_TOKEN_NUMBER
+        double real;        // SEAPLUS_TOKEN_FLOAT
+    } value;
+    const char *text;       // the source text (length bytes, not NUL-terminated), valid until
+                            // the context lexes something else or is destroyed
+} SeaplusToken;
+
+/* A lexing context: the tokens of the buffer lexed last and the symbol IDs handed out so far.
+ * A context is used by one thread at a time; create one per thread to lex in parallel. */
+typedef struct SeaplusLexer SeaplusLexer;
+
+/* SEAPLUS_LEXER_API_VERSION of the library, which may be newer than the header */
+SEAPLUS_API int seaplus_lexer_version(void);
+
+/* Returns NULL when out of memory */
+SEAPLUS_API SeaplusLexer *seaplus_lexer_create(void);
+
+/* Lex length bytes of data, replacing the previous buffer's tokens. data is copied, the
+ * caller can free it right away. Returns 0, or -1 when out of memory or over 4 GiB */
+SEAPLUS_API int seaplus_lexer_lex(SeaplusLexer *lexer, const char *data, size_t length);
+
+/* The same for a file ("-" for stdin), mapped instead of copied when it can be.
+ * Returns 0, or -1 when it cannot be read (errno is set) or lexed */
+SEAPLUS_API int seaplus_lexer_lex_file(SeaplusLexer *lexer, const char *path);
+
+/* Tokens of the current buffer, the final SEAPLUS_TOKEN_EOF included */
+SEAPLUS_API size_t seaplus_lexer_count(const SeaplusLexer *lexer);
+
+/* Token index. Returns 0, or -1 when index is past the last token */
+SEAPLUS_API int seaplus_lexer_get(SeaplusLexer *lexer, size_t index, SeaplusToken *token);
+
+/* Iterate: the first token after a lex, then the one after it, and so on.
+ * Returns 1 with the next token, 0 once the EOF token has been returned */
+SEAPLUS_API int seaplus_lexer_next(SeaplusLexer *lexer, SeaplusToken *token);
+
+/* No partner, see seaplus_lexer_partner() */
+#define SEAPLUS_NO_PARTNER SIZE_MAX
+
+/* Index of the bracket that token index pairs with: the closing one of an opening bracket and
+ * the other way around, to skip a whole block at once. SEAPLUS_NO_PARTNER for a token that is
+ * not a bracket or one left unbalanced. Since version 2 */
+SEAPLUS_API size_t seaplus_lexer_partner(const SeaplusLexer *lexer, size_t index);
+
+/* Value of a string or char literal without an error: its text between the quotes, escapes
+ * decoded, length bytes and not always NUL-terminated. Valid as long as token->text.
+ * Returns NULL for other tokens or out of memory */
+SEAPLUS_API const char *seaplus_lexer_literal(SeaplusLexer *lexer, const SeaplusToken *token,
+                                              size_t *length);
+
+/* Name of an identifier's symbol ID, NUL-terminated, or NULL for an unknown ID.
+ * Valid until the next lex */
+SEAPLUS_API const char *seaplus_lexer_symbol_name(const SeaplusLexer *lexer, uint32_t symbol,
+                                                  size_t *length);
+
+/* "IDENTIFIER", ... and the error message of an error; "UNKNOWN" / "Unknown error" otherwise */
+SEAPLUS_API const char *seaplus_token_type_name(uint32_t type);
+SEAPLUS_API const char *seaplus_error_message(uint32_t error);
+
+SEAPLUS_API void seaplus_lexer_destroy(SeaplusLexer *lexer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEAPLUS_LEXER_H */
@@ -0,0 +1,29 @@
+/* skip.h */
+#ifndef SKIP_H
+#define SKIP_H
+
+/* Vectorized skip kernels for whitespace, comments, string literals and binary junk.
+ * All kernels scan [p, end), end being the end of the input, and return end when they find
+ * nothing. A NUL before end is an ordinary byte to them: only end ends the input.
+ * They read no byte outside [p, end): the buffers they get need no alignment or padding.
+ * They do not count lines: tokens carry offsets and lines.h turns those into line numbers.
+ */
+
+// Returns the first byte that is not ' ', '\t', '\n' or '\r'
+const char *skip_blanks(const char *p, const char *end);
+
+// Returns the next '\n' or '\r', for single line (#) comments
+const char *find_newline(const char *p, const char *end);
+
+// Returns the '*' of the next "*/", for multi line comments
+const char *find_comment_end(const char *p, const char *end);
+
+// Returns the next '"', '\\' or '\r', for the body of string literals:
+// the bytes before it stand for themselves, the one found ends the string or needs decoding
+const char *find_string_stop(const char *p, const char *end);
+
+// Returns the first byte that can be source text: printable ASCII, '\t', '\n' or '\r'.
+// Used to get past runs of control and non-ASCII bytes after an invalid character
+const char *skip_binary(const char *p, const char *end);
+
+#endif /* SKIP_H */
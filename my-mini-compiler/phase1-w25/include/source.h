@@ -0,0 +1,24 @@
+/* source.h */
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+
+/* A source file loaded for lexing.
+ * data is always followed by a '\0' terminator so the lexer can run straight over it.
+ * Regular files are memory-mapped in place, anything else (pipes, stdin, ...) is read
+ * into a heap buffer.
+ */
+typedef struct {
+    const char *data;   // File contents, NUL-terminated
+    size_t length;      // Number of bytes in the file (without the terminator)
+    size_t map_length;  // Size of the mapping, 0 when data lives on the heap
+} SourceFile;
+
+/* Load path ("-" for stdin) into src. Returns 0 on success, -1 on failure (errno is set) */
+int source_open(SourceFile *src, const char *path);
+
+/* Release whatever source_open() acquired */
+void source_close(SourceFile *src);
+
+#endif /* SOURCE_H */
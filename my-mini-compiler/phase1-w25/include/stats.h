@@ -0,0 +1,59 @@
+/* stats.h */
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "tokens.h"
+
+#define STATS_TOKEN_TYPES (TOKEN_FLOAT + 1)
+#define STATS_ERROR_TYPES (ERROR_UNMATCHED_DELIMITER + 1)
+
+/* Lexer counters. Each thread fills its own copy and the copies are merged at the end, so
+ * counting costs a few adds and compares per token and no synchronization.
+ * Bytes skipped as whitespace and comments are the input bytes no token covers, so they
+ * need no counting at all.
+ */
+typedef struct {
+    uint64_t tokens[STATS_TOKEN_TYPES];         // by TokenType
+    uint64_t errors[STATS_ERROR_TYPES];         // by ErrorType, ERROR_NONE unused
+    uint64_t lexeme_bytes[STATS_TOKEN_TYPES];   // total lexeme length by TokenType
+    uint64_t shortest[STATS_TOKEN_TYPES];       // lexeme length, UINT64_MAX before the first
+    uint64_t longest[STATS_TOKEN_TYPES];
+    uint64_t files;
+    uint64_t bytes;                             // input bytes lexed
+    double seconds;                             // wall time, set by whoever times the run
+} LexStats;
+
+void stats_init(LexStats *stats);
+
+static inline void stats_add_token(LexStats *stats, const Token *token) {
+    size_t type = (size_t)token->type;
+    stats->tokens[type]++;
+    stats->errors[token->error]++;
+    stats->lexeme_bytes[type] += token->length;
+    if (token->length < stats->shortest[type]) {
+        stats->shortest[type] = token->length;
+    }
+    if (token->length > stats->longest[type]) {
+        stats->longest[type] = token->length;
+    }
+}
+
+/* One more input of length bytes */
+static inline void stats_add_input(LexStats *stats, uint64_t length) {
+    stats->files++;
+    stats->bytes += length;
+}
+
+/* Add the counts in from to into */
+void stats_merge(LexStats *into, const LexStats *from);
+
+/* Human-readable summary */
+void stats_print(FILE *out, const LexStats *stats);
+
+/* Prometheus text format, written to a temporary file and renamed over path so a collector
+ * never reads half a file. Returns 0, or -1 when the file cannot be written */
+int stats_write_prometheus(const char *path, const LexStats *stats);
+
+#endif /* STATS_H */
@@ -0,0 +1,51 @@
+/* stream.h */
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdio.h>
+#include "lexer.h"
+#include "lines.h"
+
+#define STREAM_DEFAULT_WINDOW (64 * 1024)
+#define STREAM_MIN_WINDOW 64
+
+/* Streaming lexer: lexes any FILE (pipes, stdin, ...) through a fixed-size window that is
+ * refilled as tokens are consumed, so memory use does not depend on the input size.
+ * Tokens carry absolute offsets into the stream. Their text stays in the window only until
+ * the next stream_next_token() call, see stream_lexeme().
+ * A lexeme longer than the whole window is reported as ERROR_STRING_OVERFLOW (strings) or
+ * ERROR_TOKEN_OVERFLOW (identifiers and numbers) and skipped.
+ * Line numbers come from an index of the lines in the window, rebuilt on every refill and
+ * carried over by counting: see stream_position().
+ */
+typedef struct {
+    FILE *file;
+    char *buffer;       // window, always NUL-terminated at fill
+    size_t capacity;    // window size in bytes
+    size_t fill;        // bytes of input currently in the window
+    size_t base;        // stream offset of buffer[0]
+    int eof;            // file has been read to the end
+    int comment;        // comment left open at the end of the window: 0, '#' or '*'
+    Lexer lexer;        // runs over the window; pos and previous token carry across refills
+    SymbolTable *symbols;   // from the options; identifiers are interned once they are final
+    LineIndex lines;    // lines from the one holding buffer[0] to the end of the window
+    int split_cr;       // the window ended in a '\r' whose '\n' may be in the next chunk
+    LinePos oversized;  // where the last oversized token started, its text is gone
+} LexStream;
+
+/* Set up a stream over file with a window of window bytes (0 picks the default).
+ * options may be NULL for the defaults. Returns 0 on success */
+int stream_open(LexStream *stream, FILE *file, size_t window, const LexerOptions *options);
+
+/* Lex the next token from the stream */
+Token stream_next_token(LexStream *stream);
+
+/* Start of the token's text in the window, valid until the next stream_next_token() call */
+const char *stream_lexeme(const LexStream *stream, const Token *token);
+
+/* Line and column of the token stream_next_token() just returned */
+LinePos stream_position(const LexStream *stream, const Token *token);
+
+void stream_close(LexStream *stream);
+
+#endif /* STREAM_H */
@@ -0,0 +1,58 @@
+/* symbols.h */
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Symbol ID of tokens that are not interned identifiers */
+#define SYMBOL_NONE 0
+
+typedef struct {
+    uint32_t hash;
+    uint32_t symbol;    // SYMBOL_NONE for an empty slot
+} SymbolSlot;
+
+/* Intern table: every distinct identifier gets a dense symbol ID (1, 2, 3, ... in order of
+ * first appearance) and its text is stored once. Open addressing with linear probing over a
+ * power-of-two slot array that is kept at most half full.
+ * A table is not thread-safe; give each lexer that runs on its own thread its own table.
+ */
+typedef struct {
+    SymbolSlot *slots;
+    size_t mask;            // slot count - 1
+    char *names;            // all names, each NUL-terminated
+    size_t names_size;
+    size_t names_capacity;
+    uint32_t *starts;       // starts[id]: offset of the name in names (index 0 unused)
+    uint32_t *lengths;      // lengths[id]: length of the name
+    uint32_t count;         // symbols interned, the highest ID in use
+    uint32_t capacity;      // entries in starts and lengths
+} SymbolTable;
+
+/* Returns 0 on success, -1 when out of memory */
+int symbols_init(SymbolTable *table);
+
+/* The running keyword hash of name (KEYWORD_HASH_STEP), which the lexer already has for
+ * every identifier it scans */
+unsigned int symbol_hash(const char *name, size_t length);
+
+/* ID of name, adding it if it is new. hash must be symbol_hash(name, length).
+ * Returns SYMBOL_NONE when out of memory */
+uint32_t symbols_intern(SymbolTable *table, const char *name, size_t length, unsigned int hash);
+
+/* ID of name if it has been interned, else SYMBOL_NONE */
+uint32_t symbols_find(const SymbolTable *table, const char *name, size_t length, unsigned int hash);
+
+/* Text of a symbol, NUL-terminated; valid until the next symbols_intern() call */
+static inline const char *symbol_name(const SymbolTable *table, uint32_t symbol) {
+    return table->names + table->starts[symbol];
+}
+
+static inline size_t symbol_length(const SymbolTable *table, uint32_t symbol) {
+    return table->lengths[symbol];
+}
+
+void symbols_free(SymbolTable *table);
+
+#endif /* SYMBOLS_H */
@@ -0,0 +1,64 @@
+/* token_iter.h */
+#ifndef TOKEN_ITER_H
+#define TOKEN_ITER_H
+
+#include <stddef.h>
+#include "tokens.h"
+#include "lexer.h"
+
+/* Fewest tokens lexed per refill */
+#define TOKEN_ITER_BATCH 64
+
+/* Pull iterator for the parser: next() hands out tokens in order and peek(k) looks k tokens
+ * ahead of it. Tokens are lexed a batch at a time into a ring of pre-lexed tokens (a power of
+ * two, masked instead of wrapped), so looking ahead never lexes the same bytes twice.
+ * head and tail count tokens handed out and lexed; ring[i & mask] holds token i.
+ */
+typedef struct {
+    Lexer lexer;
+    Token *ring;
+    size_t mask;            // slots - 1
+    size_t head;            // next token next() returns
+    size_t tail;            // next token to lex
+    size_t lookahead;       // peek() accepts k < lookahead
+    int done;               // TOKEN_EOF has been lexed
+    Token eof;              // the EOF token, returned again for everything past it
+} TokenIter;
+
+/* Iterate over the tokens of input with room to peek lookahead tokens ahead (at least 1).
+ * options may be NULL for the defaults. Returns 0, or -1 when out of memory */
+int token_iter_init(TokenIter *iter, const char *input, size_t length, size_t lookahead,
+                    const LexerOptions *options);
+
+/* Lex into every free slot of the ring, stopping at TOKEN_EOF */
+void token_iter_fill(TokenIter *iter);
+
+/* Token k places ahead (0 is the one next() returns next), or NULL when k is not below the
+ * lookahead. The pointer stays valid until next() hands that token out. */
+static inline const Token *token_iter_peek(TokenIter *iter, size_t k) {
+    if (k >= iter->lookahead) {
+        return NULL;
+    }
+    if (iter->tail - iter->head <= k && !iter->done) {
+        token_iter_fill(iter);
+    }
+    if (iter->tail - iter->head <= k) {
+        return &iter->eof;
+    }
+    return &iter->ring[(iter->head + k) & iter->mask];
+}
+
+/* The next token; TOKEN_EOF again and again once the input is done */
+static inline Token token_iter_next(TokenIter *iter) {
+    if (iter->head == iter->tail && !iter->done) {
+        token_iter_fill(iter);
+    }
+    if (iter->head == iter->tail) {
+        return iter->eof;
+    }
+    return iter->ring[iter->head++ & iter->mask];
+}
+
+void token_iter_free(TokenIter *iter);
+
+#endif /* TOKEN_ITER_H */
@@ -0,0 +1,49 @@
+/* token_stream.h */
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "tokens.h"
+#include "lexer.h"
+
+/* Longest input lex_all() takes: offsets and lengths are stored in 32 bits */
+#define TOKEN_STREAM_MAX_INPUT ((size_t)UINT32_MAX - 1)
+
+/* The tokens of a whole buffer as columns: token i is kinds[i], errors[i], starts[i], ...
+ * A pass that only needs kinds and starts touches 5 of the 23 bytes a token takes here,
+ * against a whole Token struct per token otherwise. Line numbers come from a LineIndex of
+ * the source (lines.h).
+ */
+typedef struct {
+    unsigned char *kinds;       // TokenType
+    unsigned char *errors;      // ErrorType
+    unsigned char *flags;       // TOKEN_FLAG_* bits
+    uint32_t *starts;           // offset of the first character in the source buffer
+    uint32_t *lengths;          // number of source characters
+    uint32_t *symbols;          // symbol IDs, SYMBOL_NONE unless options->symbols was given
+    uint64_t *values;           // Token.value of number literals (the bits of a float's), else 0
+    size_t count;               // tokens, the last one is TOKEN_EOF
+    size_t capacity;
+} TokenStream;
+
+/* Lex all of input into out in one call, without a function call or Token copy per token.
+ * options may be NULL for the defaults. Returns 0, or -1 when out of memory or when the
+ * input is longer than TOKEN_STREAM_MAX_INPUT.
+ */
+int lex_all(const char *input, size_t length, const LexerOptions *options, TokenStream *out);
+
+/* Token i of the stream as a Token, for code that wants one */
+static inline Token token_stream_get(const TokenStream *stream, size_t i) {
+    Token token = {(TokenType)stream->kinds[i], (ErrorType)stream->errors[i],
+                   stream->starts[i], stream->lengths[i], stream->symbols[i], stream->flags[i],
+                   {stream->values[i]}};
+    return token;
+}
+
+/* Make room for capacity tokens. Returns 0, or -1 when out of memory (the stream is unchanged) */
+int token_stream_reserve(TokenStream *stream, size_t capacity);
+
+void token_stream_free(TokenStream *stream);
+
+#endif /* TOKEN_STREAM_H */
@@ -3,6 +3,9 @@
 #ifndef TOKENS_H
 #define TOKENS_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 /* Token types that need to be recognized by the lexer
  * TODO: Add more token types as per requirements:
  * - Keywords or reserved words (if, repeat, until)
@@ -21,7 +24,8 @@ typedef enum {
     TOKEN_STRING_LITERAL,   // e.g. "SeaPlus+"
     TOKEN_CHAR_LITERAL,     // e.g. 'c'
     TOKEN_DELIMITER,        // e.g. {} [] ()
-    TOKEN_SPECIAL_CHARACTER // e.g. _ &
+    TOKEN_SPECIAL_CHARACTER, // e.g. _ &
+    TOKEN_FLOAT             // e.g. 1.5 2e10 6.02e+23
 } TokenType;
 
 /* Error types for lexical analysis
@@ -36,19 +40,33 @@ typedef enum {
     ERROR_UNTERMINATED_STRING,
     ERROR_INVALID_ESCAPE_CHARACTER,
     ERROR_UNTERMINATED_CHARACTER,
-    ERROR_OPEN_DELIMITER
+    ERROR_OPEN_DELIMITER,       // bracket never closed
+    ERROR_TOKEN_OVERFLOW,       // lexeme longer than the streaming window
+    ERROR_UNMATCHED_DELIMITER   // closing bracket without an open one of its kind
 } ErrorType;
 
+/* Token.flags: the literal's text has escape sequences or raw \r line breaks, so
+ * token_text() has to decode it. Without it the text is the source span as it is */
+#define TOKEN_FLAG_ESCAPES 0x1u
+
 /* Token structure to store token information
- * TODO: Add more fields if needed for your implementation
- * Hint: You might want to consider adding line and column tracking if you want to debug your lexer properly.
- * Don't forget to update the token fields in lexer.c as well
+ * A token does not own its text: start and length give its span in the source buffer.
+ * Use token_text() (lexer.c) to get the decoded text when it is needed, and a LineIndex
+ * (lines.h) of the buffer for its line and column.
  */
 typedef struct {
     TokenType type;
-    char lexeme[100];   // Actual text of the token
-    int line;           // Line number in source file
     ErrorType error;    // Error type if any
+    size_t start;       // Offset of the first character in the source buffer
+    size_t length;      // Number of source characters in the token
+    uint32_t symbol;    // Symbol ID of an interned identifier (symbols.h), else 0
+    uint32_t flags;     // TOKEN_FLAG_* bits
+    union {
+        uint64_t integer;   // TOKEN_NUMBER
+        double real;        // TOKEN_FLOAT
+    } value;            // Value of a number literal, parsed while lexing, else 0
 } Token;
 
+size_t token_text(const char *input, const Token *token, char *out, size_t out_size);
+
 #endif /* TOKENS_H */
@@ -0,0 +1,82 @@
+// tokens.spec
+// SeaPlus+ token rules. tools/gen_scanner.c compiles them at build time into the
+// character class and transition tables the scanner in lexer.c runs on (scanner_tables.h).
+// Reserved words are listed in keywords.def and picked out of identifiers by the keyword hash.
+//
+// Every rule is:  KIND  PATTERN  [CLASS]
+//   KIND     what the scanner does with the match, one of the sections below
+//   PATTERN  the characters to match: [a-z0-9] is a set, a * right after a set repeats it zero
+//            or more times, \ takes the next character literally (\s is a space, \t \n \r
+//            the usual control characters)
+//   CLASS    the last_token_type the token leaves behind, for the consecutive operator check
+// The longest match wins, and between rules matching the same text the first one listed.
+// Every prefix of a match must be matched by some rule too (the / of /* is an operator, the
+// _ of _x a special character), so the scanner never has to back up.
+
+// Whitespace and comments: the pattern only recognizes the start, the scanner skips the rest
+blank           [\s\t\n\r]
+line_comment    #
+block_comment   /*
+
+// Literals
+number          [0-9][0-9]*                     n
+identifier      [a-zA-Z][a-zA-Z0-9_]*           i
+identifier      _[a-zA-Z0-9][a-zA-Z0-9_]*       i
+string          "
+char            '
+
+// Operators
+// Standalone
+operator        $       u
+// Can be trailed by one repetition or an equals sign
+operator        +       o
+operator        ++      o
+operator        +=      q
+operator        -       o
+operator        --      o
+operator        -=      q
+// Can be trailed only by an equals sign
+operator        *       o
+operator        *=      q
+operator        /       o
+operator        /=      q
+operator        %       o
+operator        %=      q
+operator        =       o
+operator        ==      q
+operator        !       u
+operator        !=      q
+// Can be trailed only by itself
+operator        |       o
+operator        ||      o
+operator        ^       o
+operator        ^^      o
+// Can be trailed by itself or a question mark and can't stand alone, a lone & is a special character
+operator        &&      o
+operator        &?      o
+// Can repeat 3 times or be trailed by an equals sign
+operator        <       o
+operator        <=      o
+operator        <<      o
+operator        <<<     o
+operator        >       o
+operator        >=      o
+operator        >>      o
+operator        >>>     o
+// Operators starting with these may directly follow another operator (!!true, $$5),
+// any other operator right after one is a consecutive operator error
+follows_operator        !$
+
+// Delimiters: brackets (must be closed) and separators
+delimiter       (       b
+delimiter       )       b
+delimiter       {       b
+delimiter       }       b
+delimiter       \[      b
+delimiter       ]       b
+delimiter       ;       d
+delimiter       ,       d
+
+// Special characters
+special         &       z
+special         _       z
@@ -0,0 +1,117 @@
+/* tokfile.h */
+#ifndef TOKFILE_H
+#define TOKFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "tokens.h"
+#include "lines.h"
+#include "source.h"
+#include "symbols.h"
+#include "token_stream.h"
+
+/* Binary token file (.tok): a lexed source that later phases map and use as it is.
+ *
+ *   header     TokHeader
+ *   records    token_count TokRecords
+ *   symbols    symbol_count + 1 uint32 offsets into names (entry 0 unused), then the names,
+ *              each NUL-terminated
+ *   lines      line_count uint32 offsets: where each source line starts (a LineIndex)
+ *   source     the source text and a NUL terminator, so lexemes and token_text() work
+ *
+ * Every section starts at a multiple of 8 bytes. Numbers are in the byte order of the machine
+ * that wrote the file; a reader on the other byte order rejects it (see byte_order).
+ */
+#define TOKFILE_MAGIC "SPTK"
+#define TOKFILE_VERSION 4
+#define TOKFILE_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[4];              // TOKFILE_MAGIC
+    uint16_t version;           // TOKFILE_VERSION
+    uint16_t record_size;       // sizeof(TokRecord)
+    uint32_t byte_order;        // TOKFILE_BYTE_ORDER as the writer stored it
+    uint32_t symbol_count;
+    uint32_t line_count;
+    uint32_t reserved;
+    uint64_t token_count;
+    uint64_t source_length;     // without the terminator
+    uint64_t records_offset;    // file offsets of the sections
+    uint64_t symbols_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+    uint64_t lines_offset;
+    uint64_t source_offset;
+} TokHeader;
+
+typedef struct {
+    uint8_t type;               // TokenType
+    uint8_t error;              // ErrorType
+    uint8_t flags;              // TOKEN_FLAG_* bits
+    uint8_t reserved;
+    uint32_t start;             // offset into the source section
+    uint32_t length;
+    uint32_t symbol;            // identifiers: index into the symbol table, else 0
+    uint64_t value;             // number literals: Token.value (a float's bits), else 0
+} TokRecord;
+
+/* Write a lexed source as a .tok file. symbols may be NULL when tokens carry no symbol IDs.
+ * Returns 0, or -1 on a write error */
+int tokfile_write(FILE *out, const char *source, size_t length, const TokenStream *tokens,
+                  const SymbolTable *symbols);
+
+/* A .tok file mapped for reading */
+typedef struct {
+    SourceFile file;            // the mapping
+    const TokHeader *header;
+    const TokRecord *records;
+    size_t count;
+    const uint32_t *symbol_starts;
+    const char *names;
+    uint32_t symbol_count;
+    const uint32_t *line_starts;
+    uint32_t line_count;
+    const char *source;
+    size_t source_length;
+} TokFile;
+
+/* Map path and check its header and section bounds. Nothing is copied and the records are not
+ * walked: each one is checked when tokfile_token() or tokfile_symbol() reads it. A damaged line
+ * index only gives wrong line numbers, line_index_locate() never reads outside it.
+ * Returns 0, or -1 when the file cannot be read or is not a valid .tok file */
+int tokfile_open(TokFile *tok, const char *path);
+
+void tokfile_close(TokFile *tok);
+
+/* Token i (below tok->count), with offsets into tok->source. Returns 0, or -1 when the record
+ * is damaged: a type or error out of range, text outside the source or a symbol outside the table */
+static inline int tokfile_token(const TokFile *tok, size_t i, Token *token) {
+    const TokRecord *r = &tok->records[i];
+    if (r->type > TOKEN_FLOAT || r->error > ERROR_UNMATCHED_DELIMITER ||
+        (uint64_t)r->start + r->length > tok->source_length || r->symbol > tok->symbol_count) {
+        return -1;
+    }
+    Token record = {(TokenType)r->type, (ErrorType)r->error, r->start, r->length, r->symbol, r->flags,
+                    {r->value}};
+    *token = record;
+    return 0;
+}
+
+/* The file's line index, for the line numbers of its tokens. It points into the mapping:
+ * use it until tokfile_close(), line_index_free() leaves it alone */
+static inline LineIndex tokfile_lines(const TokFile *tok) {
+    LineIndex lines = {(uint32_t *)tok->line_starts, tok->line_count, 0, 0, 1};
+    return lines;
+}
+
+/* Name of a symbol, NUL-terminated (the names section ends in a NUL). NULL when symbol is not
+ * an ID in 1..symbol_count or its entry points outside the names */
+static inline const char *tokfile_symbol(const TokFile *tok, uint32_t symbol) {
+    if (symbol == 0 || symbol > tok->symbol_count || tok->symbol_starts[symbol] >= tok->header->names_size) {
+        return NULL;
+    }
+    return tok->names + tok->symbol_starts[symbol];
+}
+
+#endif /* TOKFILE_H */
@@ -0,0 +1,464 @@
+/* batch.c
+ * Multi-file driver: lexes many files on a work-stealing thread pool and writes their output
+ * in the order the files were given.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/batch.h"
+#include "../include/emit.h"
+#include "../include/lexer.h"
+#include "../include/source.h"
+
+/* Files waiting for one worker: the owner takes from the head, thieves from the tail */
+typedef struct {
+    size_t *items;
+    size_t head, tail;
+    pthread_mutex_t lock;
+} WorkQueue;
+
+typedef struct {
+    Batch *batch;
+    const Emitter *config;          // output format every file's emitter copies
+    WorkQueue *queues;
+    size_t workers;
+    pthread_mutex_t done_lock;      // guards BatchFile.taken and .done, pending and next_free
+    pthread_cond_t done_cond;
+    size_t pending;                 // output bytes finished but not yet written
+    size_t next_free;               // every file before it is taken
+} Pool;
+
+typedef struct {
+    Pool *pool;
+    size_t self;
+    LexStats stats;                 // this worker's counters, merged after the run
+} Worker;
+
+typedef struct {
+    size_t size;
+    size_t index;
+} SizedFile;
+
+void batch_init(Batch *batch) {
+    batch->files = NULL;
+    batch->count = 0;
+    batch->capacity = 0;
+}
+
+static char *copy_string(const char *text) {
+    size_t length = strlen(text);
+    char *copy = malloc(length + 1);
+    if (copy != NULL) {
+        memcpy(copy, text, length + 1);
+    }
+    return copy;
+}
+
+int batch_add_file(Batch *batch, const char *path, const char *title) {
+    if (batch->count == batch->capacity) {
+        size_t capacity = batch->capacity != 0 ? batch->capacity * 2 : 64;
+        BatchFile *files = realloc(batch->files, capacity * sizeof(BatchFile));
+        if (!files) {
+            return -1;
+        }
+        batch->files = files;
+        batch->capacity = capacity;
+    }
+    BatchFile *file = &batch->files[batch->count];
+    memset(file, 0, sizeof(*file));
+    file->path = copy_string(path);
+    file->title = copy_string(title != NULL ? title : path);
+    if (!file->path || !file->title) {
+        free(file->path);
+        free(file->title);
+        return -1;
+    }
+    // a file that cannot be stat'ed is still added, lexing it reports the error in its place
+    struct stat info;
+    if (stat(path, &info) == 0) {
+        file->size = (size_t)info.st_size;
+    }
+    batch->count++;
+    return 0;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Add every regular file under directory, in name order so runs are reproducible */
+static int add_directory(Batch *batch, const char *directory) {
+    DIR *dir = opendir(directory);
+    if (dir == NULL) {
+        return -1;
+    }
+    char **names = NULL;
+    size_t count = 0, capacity = 0;
+    int result = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;  // ".", ".." and hidden files
+        }
+        if (count == capacity) {
+            capacity = capacity != 0 ? capacity * 2 : 32;
+            char **grown = realloc(names, capacity * sizeof(char *));
+            if (!grown) {
+                result = -1;
+                break;
+            }
+            names = grown;
+        }
+        if ((names[count] = copy_string(entry->d_name)) == NULL) {
+            result = -1;
+            break;
+        }
+        count++;
+    }
+    closedir(dir);
+    qsort(names, count, sizeof(char *), compare_names);
+
+    size_t prefix = strlen(directory);
+    int slash = prefix > 0 && directory[prefix - 1] == '/';
+    for (size_t i = 0; i < count; i++) {
+        if (result != 0) {
+            free(names[i]);
+            continue;
+        }
+        size_t length = prefix + 1 + strlen(names[i]);
+        char *path = malloc(length + 1);
+        if (!path) {
+            result = -1;
+            free(names[i]);
+            continue;
+        }
+        snprintf(path, length + 1, slash ? "%s%s" : "%s/%s", directory, names[i]);
+
+        // symbolic links to directories are not followed, so the walk always ends
+        struct stat info;
+        if (lstat(path, &info) == 0) {
+            if (S_ISDIR(info.st_mode)) {
+                result = add_directory(batch, path);
+            } else if (S_ISREG(info.st_mode) ||
+                       (S_ISLNK(info.st_mode) && stat(path, &info) == 0 && S_ISREG(info.st_mode))) {
+                result = batch_add_file(batch, path, NULL);
+            }
+        }
+        free(path);
+        free(names[i]);
+    }
+    free(names);
+    return result;
+}
+
+int batch_add_path(Batch *batch, const char *path) {
+    struct stat info;
+    if (stat(path, &info) == 0 && S_ISDIR(info.st_mode)) {
+        return add_directory(batch, path);
+    }
+    return batch_add_file(batch, path, NULL);
+}
+
+int batch_add_list(Batch *batch, const char *list_path) {
+    FILE *list = strcmp(list_path, "-") == 0 ? stdin : fopen(list_path, "r");
+    if (list == NULL) {
+        return -1;
+    }
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t length;
+    int result = 0;
+    while (result == 0 && (length = getline(&line, &size, list)) != -1) {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+            line[--length] = '\0';
+        }
+        if (length > 0) {
+            result = batch_add_path(batch, line);
+        }
+    }
+    free(line);
+    if (list != stdin) {
+        fclose(list);
+    }
+    return result;
+}
+
+/* Lex one file, keeping everything it prints in memory */
+static void lex_file(BatchFile *file, const Emitter *config, LexStats *stats) {
+    Emitter emitter;
+    if (emitter_init_like(&emitter, config) != 0) {
+        file->failed = 1;
+        return;
+    }
+
+    SourceFile source;
+    LineIndex lines;
+    LineCursor cursor;
+    int indexed = 0;
+    if (source_open(&source, file->path) != 0) {
+        emit_open_error(&emitter, file->title);
+        file->failed = 1;
+    } else if (!(indexed = line_index_build(&lines, source.data, source.length) == 0) &&
+               line_cursor_init(&cursor, source.data, source.length) != 0) {
+        file->failed = 1;
+        source_close(&source);
+    } else {
+        // text output keeps [WARN] notes in line with the tokens, the other formats send them to stderr
+        char *notes = NULL;
+        size_t notes_length = 0;
+        FILE *notes_out = config->format == EMIT_TEXT ? open_memstream(&notes, &notes_length) : stderr;
+        LexerOptions options = {1, notes_out != NULL ? notes_out : stderr, NULL};
+        Lexer lexer;
+        lexer_init(&lexer, source.data, source.length, &options);
+        Token token;
+
+        emit_file_header(&emitter, file->title, source.data, source.length);
+        emitter.lines = indexed ? &lines : NULL;
+        stats_add_input(stats, source.length);
+        do {
+            token = get_next_token(&lexer);
+            stats_add_token(stats, &token);
+            if (token.type == TOKEN_EOF && notes_out != stderr && notes_out != NULL) {
+                // the only note, an unclosed comment, runs into the end of the input
+                fflush(notes_out);
+                emit_raw(&emitter, notes, notes_length);
+            }
+            if (indexed) {
+                emit_token(&emitter, source.data, &token);
+            } else {
+                // over 4 GiB the lines are counted as the tokens go by
+                emit_token_at(&emitter, source.data + token.start, &token,
+                              line_cursor_locate(&cursor, token.start));
+            }
+        } while (token.type != TOKEN_EOF);
+        emit_diagnostics(&emitter, source.data);
+        if (notes_out != stderr && notes_out != NULL) {
+            fclose(notes_out);
+            free(notes);
+        }
+        if (indexed) {
+            line_index_free(&lines);
+        } else {
+            line_cursor_free(&cursor);
+        }
+        source_close(&source);
+    }
+
+    file->failed |= emitter.failed;
+    file->output = emitter_take(&emitter, &file->output_length);
+    emitter_close(&emitter);
+}
+
+/* Mark a file taken; 0 when a worker already took it out of queue order */
+static int claim_file(Pool *pool, size_t index) {
+    pthread_mutex_lock(&pool->done_lock);
+    BatchFile *file = &pool->batch->files[index];
+    int claimed = !file->taken;
+    file->taken = 1;
+    pthread_mutex_unlock(&pool->done_lock);
+    return claimed;
+}
+
+/* Next file for worker self: its own largest, else the smallest left with another worker.
+ * With too much output held back, the first file not taken yet: the writer is waiting on it
+ * or on one already being lexed, so that output goes out soon */
+static int take_file(Pool *pool, size_t self, size_t *index) {
+    pthread_mutex_lock(&pool->done_lock);
+    if (pool->pending >= BATCH_PENDING_LIMIT) {
+        Batch *batch = pool->batch;
+        while (pool->next_free < batch->count && batch->files[pool->next_free].taken) {
+            pool->next_free++;
+        }
+        int found = pool->next_free < batch->count;
+        if (found) {
+            *index = pool->next_free;
+            batch->files[*index].taken = 1;
+        }
+        pthread_mutex_unlock(&pool->done_lock);
+        return found;
+    }
+    pthread_mutex_unlock(&pool->done_lock);
+
+    WorkQueue *own = &pool->queues[self];
+    for (;;) {
+        pthread_mutex_lock(&own->lock);
+        int found = own->head < own->tail;
+        if (found) {
+            *index = own->items[own->head++];
+        }
+        pthread_mutex_unlock(&own->lock);
+        if (!found) {
+            break;
+        }
+        if (claim_file(pool, *index)) {
+            return 1;
+        }
+    }
+
+    for (size_t k = 1; k < pool->workers; k++) {
+        WorkQueue *victim = &pool->queues[(self + k) % pool->workers];
+        for (;;) {
+            pthread_mutex_lock(&victim->lock);
+            int found = victim->head < victim->tail;
+            if (found) {
+                *index = victim->items[--victim->tail];
+            }
+            pthread_mutex_unlock(&victim->lock);
+            if (!found) {
+                break;
+            }
+            if (claim_file(pool, *index)) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void *worker_main(void *arg) {
+    Worker *worker = arg;
+    Pool *pool = worker->pool;
+    size_t index;
+    // no work is added while running, so empty queues everywhere means the batch is done
+    while (take_file(pool, worker->self, &index)) {
+        BatchFile *file = &pool->batch->files[index];
+        lex_file(file, pool->config, &worker->stats);
+        pthread_mutex_lock(&pool->done_lock);
+        file->done = 1;
+        pool->pending += file->output_length;
+        pthread_cond_broadcast(&pool->done_cond);
+        pthread_mutex_unlock(&pool->done_lock);
+    }
+    return NULL;
+}
+
+static int compare_sizes(const void *a, const void *b) {
+    const SizedFile *x = a, *y = b;
+    if (x->size != y->size) {
+        return x->size < y->size ? 1 : -1;  // largest first
+    }
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+int batch_run(Batch *batch, int threads, Emitter *out, LexStats *stats) {
+    if (batch->count == 0) {
+        return 0;
+    }
+    size_t workers = threads > 0 ? (size_t)threads : (size_t)sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers == 0 || workers == (size_t)-1) {
+        workers = 1;
+    }
+    if (workers > batch->count) {
+        workers = batch->count;
+    }
+
+    Pool pool;
+    pool.batch = batch;
+    pool.config = out;
+    pool.workers = workers;
+    pool.queues = calloc(workers, sizeof(WorkQueue));
+    SizedFile *order = malloc(batch->count * sizeof(SizedFile));
+    size_t per_queue = (batch->count + workers - 1) / workers;
+    size_t *items = malloc(per_queue * workers * sizeof(size_t));
+    Worker *contexts = malloc(workers * sizeof(Worker));
+    pthread_t *handles = malloc(workers * sizeof(pthread_t));
+    if (!pool.queues || !order || !items || !contexts || !handles) {
+        free(pool.queues);
+        free(order);
+        free(items);
+        free(contexts);
+        free(handles);
+        return -1;
+    }
+
+    // deal the files out largest first, round robin, so every queue starts with a fair share
+    for (size_t i = 0; i < batch->count; i++) {
+        order[i].size = batch->files[i].size;
+        order[i].index = i;
+        batch->files[i].taken = 0;
+        batch->files[i].done = 0;
+    }
+    qsort(order, batch->count, sizeof(SizedFile), compare_sizes);
+    for (size_t w = 0; w < workers; w++) {
+        pool.queues[w].items = items + w * per_queue;
+        pool.queues[w].head = 0;
+        pool.queues[w].tail = 0;
+        pthread_mutex_init(&pool.queues[w].lock, NULL);
+    }
+    for (size_t i = 0; i < batch->count; i++) {
+        WorkQueue *queue = &pool.queues[i % workers];
+        queue->items[queue->tail++] = order[i].index;
+    }
+    pthread_mutex_init(&pool.done_lock, NULL);
+    pthread_cond_init(&pool.done_cond, NULL);
+    pool.pending = 0;
+    pool.next_free = 0;
+
+    size_t started = 0;
+    for (size_t w = 0; w < workers; w++) {
+        contexts[w].pool = &pool;
+        contexts[w].self = w;
+        stats_init(&contexts[w].stats);
+        if (pthread_create(&handles[started], NULL, worker_main, &contexts[w]) != 0) {
+            break;
+        }
+        started++;
+    }
+    if (started == 0) {
+        worker_main(&contexts[0]);  // no threads at all, lex everything here
+    }
+
+    // write each file's output as soon as it and everything before it is finished
+    emit_begin(out);
+    int failed = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        BatchFile *file = &batch->files[i];
+        pthread_mutex_lock(&pool.done_lock);
+        while (!file->done) {
+            pthread_cond_wait(&pool.done_cond, &pool.done_lock);
+        }
+        pthread_mutex_unlock(&pool.done_lock);
+
+        if (file->output != NULL) {
+            emit_raw(out, file->output, file->output_length);
+        }
+        free(file->output);
+        file->output = NULL;
+        pthread_mutex_lock(&pool.done_lock);
+        pool.pending -= file->output_length;
+        pthread_mutex_unlock(&pool.done_lock);
+        failed += file->failed;
+    }
+
+    for (size_t w = 0; w < started; w++) {
+        pthread_join(handles[w], NULL);
+    }
+    for (size_t w = 0; stats != NULL && w < (started > 0 ? started : 1); w++) {
+        stats_merge(stats, &contexts[w].stats);
+    }
+    for (size_t w = 0; w < workers; w++) {
+        pthread_mutex_destroy(&pool.queues[w].lock);
+    }
+    pthread_mutex_destroy(&pool.done_lock);
+    pthread_cond_destroy(&pool.done_cond);
+    free(pool.queues);
+    free(order);
+    free(items);
+    free(contexts);
+    free(handles);
+    return failed;
+}
+
+void batch_free(Batch *batch) {
+    for (size_t i = 0; i < batch->count; i++) {
+        free(batch->files[i].path);
+        free(batch->files[i].title);
+        free(batch->files[i].output);
+    }
+    free(batch->files);
+    batch_init(batch);
+}
@@ -0,0 +1,53 @@
+/* arena.c
+ * Block-based bump allocator.
+ */
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../../include/arena.h"
+
+#define ARENA_BLOCK (64 * 1024)
+#define ARENA_ALIGN alignof(max_align_t)
+
+struct ArenaBlock {
+    ArenaBlock *previous;
+    alignas(max_align_t) char data[];
+};
+
+void arena_init(Arena *arena) {
+    arena->blocks = NULL;
+    arena->next = NULL;
+    arena->end = NULL;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    if (size > SIZE_MAX - sizeof(ArenaBlock) - ARENA_ALIGN) {
+        return NULL;
+    }
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (arena->blocks == NULL || size > (size_t)(arena->end - arena->next)) {
+        // a request bigger than a block gets a block of its own
+        size_t capacity = size > ARENA_BLOCK ? size : ARENA_BLOCK;
+        ArenaBlock *block = malloc(sizeof(ArenaBlock) + capacity);
+        if (!block) {
+            return NULL;
+        }
+        block->previous = arena->blocks;
+        arena->blocks = block;
+        arena->next = block->data;
+        arena->end = block->data + capacity;
+    }
+    void *p = arena->next;
+    arena->next += size;
+    return p;
+}
+
+void arena_free(Arena *arena) {
+    ArenaBlock *block = arena->blocks;
+    while (block != NULL) {
+        ArenaBlock *previous = block->previous;
+        free(block);
+        block = previous;
+    }
+    arena_init(arena);
+}
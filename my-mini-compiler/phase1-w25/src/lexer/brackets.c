@@ -0,0 +1,129 @@
+/* brackets.c
+ * Bracket matching over delimiter tokens.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/brackets.h"
+
+void bracket_stack_init(BracketStack *stack) {
+    stack->open = NULL;
+    stack->depth = 0;
+    stack->capacity = 0;
+}
+
+static int bracket_stack_push(BracketStack *stack, const OpenBracket *open) {
+    if (stack->depth == stack->capacity) {
+        size_t capacity = stack->capacity != 0 ? stack->capacity * 2 : 64;
+        OpenBracket *grown = realloc(stack->open, capacity * sizeof(OpenBracket));
+        if (!grown) {
+            return -1;
+        }
+        stack->open = grown;
+        stack->capacity = capacity;
+    }
+    stack->open[stack->depth++] = *open;
+    return 0;
+}
+
+BracketMatch bracket_stack_match(BracketStack *stack, const OpenBracket *bracket, size_t *unclosed) {
+    if (bracket_opens(bracket->bracket)) {
+        return bracket_stack_push(stack, bracket) == 0 ? BRACKET_OPENED : BRACKET_FAILED;
+    }
+    char c = bracket->bracket;
+    char opener = c == ')' ? '(' : c == ']' ? '[' : '{';
+    for (size_t i = stack->depth; i > 0; i--) {
+        if (stack->open[i - 1].bracket == opener) {
+            *unclosed = stack->depth - i;
+            stack->depth = i - 1;
+            return BRACKET_MATCHED;
+        }
+    }
+    return BRACKET_UNMATCHED;
+}
+
+void bracket_stack_free(BracketStack *stack) {
+    free(stack->open);
+    bracket_stack_init(stack);
+}
+
+static int add_unbalanced(BracketIndex *index, size_t *capacity, uint32_t token) {
+    if (index->unbalanced_count == *capacity) {
+        *capacity = *capacity != 0 ? *capacity * 2 : 16;
+        uint32_t *grown = realloc(index->unbalanced, *capacity * sizeof(uint32_t));
+        if (!grown) {
+            return -1;
+        }
+        index->unbalanced = grown;
+    }
+    index->unbalanced[index->unbalanced_count++] = token;
+    return 0;
+}
+
+static int compare_tokens(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+int bracket_index_build(BracketIndex *index, const TokenStream *tokens, const char *input) {
+    memset(index, 0, sizeof(*index));
+    index->count = tokens->count;
+    index->partners = malloc((tokens->count != 0 ? tokens->count : 1) * sizeof(uint32_t));
+    if (!index->partners) {
+        return -1;
+    }
+    memset(index->partners, 0xFF, tokens->count * sizeof(uint32_t));  // BRACKET_NONE
+
+    BracketStack stack;
+    bracket_stack_init(&stack);
+    size_t unbalanced_capacity = 0;
+    int result = 0;
+    // only kinds are read for most tokens; the bracket itself only for delimiters
+    for (size_t i = 0; i < tokens->count && result == 0; i++) {
+        if (tokens->kinds[i] != TOKEN_DELIMITER || tokens->errors[i] != ERROR_NONE) {
+            continue;
+        }
+        char c = input[tokens->starts[i]];
+        if (!bracket_opens(c) && !bracket_closes(c)) {
+            continue;
+        }
+        OpenBracket bracket = {tokens->starts[i], (uint32_t)i, 0, 0, c};
+        size_t unclosed = 0;
+        switch (bracket_stack_match(&stack, &bracket, &unclosed)) {
+            case BRACKET_OPENED:
+                break;
+            case BRACKET_MATCHED: {
+                uint32_t partner = stack.open[stack.depth].token;
+                index->partners[i] = partner;
+                index->partners[partner] = (uint32_t)i;
+                for (size_t k = 1; k <= unclosed && result == 0; k++) {
+                    result = add_unbalanced(index, &unbalanced_capacity, stack.open[stack.depth + k].token);
+                }
+                break;
+            }
+            case BRACKET_UNMATCHED:
+                result = add_unbalanced(index, &unbalanced_capacity, (uint32_t)i);
+                break;
+            case BRACKET_FAILED:
+                result = -1;
+                break;
+        }
+    }
+    while (stack.depth > 0 && result == 0) {
+        result = add_unbalanced(index, &unbalanced_capacity, stack.open[--stack.depth].token);
+    }
+    bracket_stack_free(&stack);
+    if (result != 0) {
+        bracket_index_free(index);
+        return -1;
+    }
+    if (index->unbalanced_count > 1) {
+        qsort(index->unbalanced, index->unbalanced_count, sizeof(uint32_t), compare_tokens);
+    }
+    return 0;
+}
+
+void bracket_index_free(BracketIndex *index) {
+    free(index->partners);
+    free(index->unbalanced);
+    memset(index, 0, sizeof(*index));
+}
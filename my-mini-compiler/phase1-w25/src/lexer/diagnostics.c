@@ -0,0 +1,57 @@
+/* diagnostics.c
+ * In-memory list of lexical errors.
+ */
+#include <stdlib.h>
+#include "../../include/diagnostics.h"
+
+void diagnostics_init(Diagnostics *diagnostics, size_t max_errors) {
+    diagnostics->items = NULL;
+    diagnostics->count = 0;
+    diagnostics->capacity = 0;
+    diagnostics->max_errors = max_errors;
+    diagnostics->total = 0;
+}
+
+int diagnostics_add(Diagnostics *diagnostics, const Token *token, LinePos pos) {
+    diagnostics->total++;
+    if (diagnostics->max_errors != 0 && diagnostics->count >= diagnostics->max_errors) {
+        return 0;
+    }
+    if (diagnostics->count == diagnostics->capacity) {
+        size_t capacity = diagnostics->capacity != 0 ? diagnostics->capacity * 2 : 64;
+        Diagnostic *items = realloc(diagnostics->items, capacity * sizeof(Diagnostic));
+        if (!items) {
+            return -1;
+        }
+        diagnostics->items = items;
+        diagnostics->capacity = capacity;
+    }
+    Diagnostic *d = &diagnostics->items[diagnostics->count++];
+    d->start = token->start;
+    d->length = (uint32_t)token->length;
+    d->kind = (uint32_t)token->error;
+    d->line = (uint32_t)pos.line;
+    d->column = (uint32_t)pos.column;
+    return 0;
+}
+
+static int compare_starts(const void *a, const void *b) {
+    uint64_t x = ((const Diagnostic *)a)->start, y = ((const Diagnostic *)b)->start;
+    return (x > y) - (x < y);
+}
+
+void diagnostics_sort(Diagnostics *diagnostics) {
+    if (diagnostics->count > 1) {
+        qsort(diagnostics->items, diagnostics->count, sizeof(Diagnostic), compare_starts);
+    }
+}
+
+void diagnostics_clear(Diagnostics *diagnostics) {
+    diagnostics->count = 0;
+    diagnostics->total = 0;
+}
+
+void diagnostics_free(Diagnostics *diagnostics) {
+    free(diagnostics->items);
+    diagnostics_init(diagnostics, diagnostics->max_errors);
+}
@@ -0,0 +1,593 @@
+/* emit.c
+ * Buffered token output in text, JSON-lines and CSV formats.
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../../include/emit.h"
+#include "../../include/lexer.h"
+
+#define EMIT_BLOCK (256 * 1024)
+#define RECORD_SLACK 256        // room for everything in a record but the lexeme
+
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+int emitter_init(Emitter *emitter, int fd, EmitFormat format, int echo) {
+    memset(emitter, 0, sizeof(*emitter));
+    emitter->format = format;
+    emitter->echo = echo;
+    emitter->fd = fd;
+    emitter->capacity = EMIT_BLOCK;
+    emitter->buffer = malloc(emitter->capacity);
+    return emitter->buffer != NULL ? 0 : -1;
+}
+
+int emitter_init_like(Emitter *emitter, const Emitter *config) {
+    if (emitter_init(emitter, -1, config->format, config->echo) != 0) {
+        return -1;
+    }
+    emitter->header_done = 1;  // the header row belongs at the start of the real output only
+    if (config->defer_errors) {
+        emitter_defer_errors(emitter, config->diagnostics.max_errors);
+    }
+    return 0;
+}
+
+void emitter_defer_errors(Emitter *emitter, size_t max_errors) {
+    emitter->defer_errors = 1;
+    emitter->diagnostics.max_errors = max_errors;
+}
+
+int emit_parse_format(const char *name, EmitFormat *format) {
+    if (strcmp(name, "text") == 0) {
+        *format = EMIT_TEXT;
+    } else if (strcmp(name, "json") == 0) {
+        *format = EMIT_JSON;
+    } else if (strcmp(name, "csv") == 0) {
+        *format = EMIT_CSV;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static int write_all(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+int emitter_flush(Emitter *emitter) {
+    if (emitter->fd >= 0 && emitter->size > 0) {
+        if (write_all(emitter->fd, emitter->buffer, emitter->size) != 0) {
+            emitter->failed = 1;
+        }
+        emitter->size = 0;
+    }
+    return emitter->failed ? -1 : 0;
+}
+
+/* Room for n more bytes at the end of the buffer, flushing or growing it as needed.
+ * Returns where they go, or NULL when out of memory */
+static char *reserve(Emitter *emitter, size_t n) {
+    if (emitter->capacity - emitter->size >= n) {
+        return emitter->buffer + emitter->size;
+    }
+    emitter_flush(emitter);
+    if (emitter->capacity - emitter->size < n) {
+        size_t capacity = emitter->capacity > 0 ? emitter->capacity * 2 : EMIT_BLOCK;
+        while (capacity - emitter->size < n) {
+            capacity *= 2;
+        }
+        char *buffer = realloc(emitter->buffer, capacity);
+        if (!buffer) {
+            emitter->failed = 1;
+            return NULL;
+        }
+        emitter->buffer = buffer;
+        emitter->capacity = capacity;
+    }
+    return emitter->buffer + emitter->size;
+}
+
+void emit_raw(Emitter *emitter, const char *data, size_t length) {
+    if (emitter->fd >= 0 && length >= EMIT_BLOCK) {
+        // big enough to skip the copy
+        emitter_flush(emitter);
+        if (write_all(emitter->fd, data, length) != 0) {
+            emitter->failed = 1;
+        }
+        return;
+    }
+    char *p = reserve(emitter, length);
+    if (p != NULL) {
+        memcpy(p, data, length);
+        emitter->size += length;
+    }
+}
+
+static inline char *put_text(char *p, const char *text) {
+    size_t length = strlen(text);
+    memcpy(p, text, length);
+    return p + length;
+}
+
+static char *put_uint(char *p, uint64_t value) {
+    char digits[20];
+    char *d = digits + sizeof(digits);
+    while (value >= 100) {
+        unsigned int pair = (unsigned int)(value % 100) * 2;
+        value /= 100;
+        *--d = digit_pairs[pair + 1];
+        *--d = digit_pairs[pair];
+    }
+    if (value >= 10) {
+        *--d = digit_pairs[value * 2 + 1];
+        *--d = digit_pairs[value * 2];
+    } else {
+        *--d = (char)('0' + value);
+    }
+    size_t length = (size_t)(digits + sizeof(digits) - d);
+    memcpy(p, d, length);
+    return p + length;
+}
+
+/* Number literals without an error, the tokens with a value */
+static int has_value(const Token *token) {
+    return token->error == ERROR_NONE && (token->type == TOKEN_NUMBER || token->type == TOKEN_FLOAT);
+}
+
+/* Value of a number literal; floats with enough digits to read back the same double */
+static char *put_value(char *p, const Token *token) {
+    if (token->type == TOKEN_NUMBER) {
+        return put_uint(p, token->value.integer);
+    }
+    return p + snprintf(p, 32, "%.17g", token->value.real);
+}
+
+/* Bytes in the UTF-8 sequence starting at s (at most left of them), or 0 when it is not valid
+ * UTF-8: a stray continuation byte, a cut-off sequence, an overlong form or a surrogate */
+static size_t utf8_sequence(const unsigned char *s, size_t left) {
+    size_t length;
+    unsigned char low = 0x80, high = 0xBF;  // allowed range of the second byte
+    if (s[0] >= 0xC2 && s[0] <= 0xDF) {
+        length = 2;
+    } else if (s[0] >= 0xE0 && s[0] <= 0xEF) {
+        length = 3;
+        low = s[0] == 0xE0 ? 0xA0 : 0x80;
+        high = s[0] == 0xED ? 0x9F : 0xBF;
+    } else if (s[0] >= 0xF0 && s[0] <= 0xF4) {
+        length = 4;
+        low = s[0] == 0xF0 ? 0x90 : 0x80;
+        high = s[0] == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        return 0;
+    }
+    if (length > left || s[1] < low || s[1] > high) {
+        return 0;
+    }
+    for (size_t i = 2; i < length; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+/* JSON string contents: at most 6 bytes out per byte in. Valid UTF-8 goes through as it
+ * is; any other byte becomes \u00XX so the line stays JSON */
+static char *put_json_escaped(char *p, const char *text, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') {
+            *p++ = (char)c;
+            continue;
+        }
+        if (c >= 0x80) {
+            size_t sequence = utf8_sequence((const unsigned char *)text + i, length - i);
+            if (sequence != 0) {
+                memcpy(p, text + i, sequence);
+                p += sequence;
+                i += sequence - 1;
+                continue;
+            }
+        }
+        *p++ = '\\';
+        switch (c) {
+            case '"': *p++ = '"'; break;
+            case '\\': *p++ = '\\'; break;
+            case '\n': *p++ = 'n'; break;
+            case '\r': *p++ = 'r'; break;
+            case '\t': *p++ = 't'; break;
+            default:
+                *p++ = 'u';
+                *p++ = '0';
+                *p++ = '0';
+                *p++ = hex[c >> 4];
+                *p++ = hex[c & 15];
+        }
+    }
+    return p;
+}
+
+/* Quoted CSV field: at most 2 bytes out per byte in, plus the quotes */
+static char *put_csv_quoted(char *p, const char *text, size_t length) {
+    *p++ = '"';
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '"') {
+            *p++ = '"';
+        }
+        *p++ = text[i];
+    }
+    *p++ = '"';
+    return p;
+}
+
+/* token_text() for a token whose own text starts at text (NULL when the text is gone) */
+static size_t lexeme_text(const char *text, const Token *token, char *out, size_t out_size) {
+    if (text == NULL) {
+        out[0] = '\0';
+        return 0;
+    }
+    Token local = *token;
+    local.start = 0;
+    return token_text(text, &local, out, out_size);
+}
+
+/* Decoded lexeme of token in the scratch buffer; returns its length, or -1 when out of memory */
+static long decode_lexeme(Emitter *emitter, const char *text, const Token *token) {
+    size_t need = token->length + 4;  // decoding never makes text longer, "EOF" is 3
+    if (emitter->scratch_capacity < need) {
+        size_t capacity = emitter->scratch_capacity ? emitter->scratch_capacity : 256;
+        while (capacity < need) {
+            capacity *= 2;
+        }
+        char *scratch = realloc(emitter->scratch, capacity);
+        if (!scratch) {
+            emitter->failed = 1;
+            return -1;
+        }
+        emitter->scratch = scratch;
+        emitter->scratch_capacity = capacity;
+    }
+    return (long)lexeme_text(text, token, emitter->scratch, emitter->scratch_capacity);
+}
+
+/* Errors the text format prints with the offending text */
+static int shows_text(ErrorType error) {
+    return error == ERROR_INVALID_CHAR || error == ERROR_OPEN_DELIMITER || error == ERROR_UNMATCHED_DELIMITER;
+}
+
+static void emit_text_token(Emitter *emitter, const char *text, const Token *token, LinePos pos) {
+    char *p = reserve(emitter, token->length + RECORD_SLACK);
+    if (p == NULL) {
+        return;
+    }
+    if (token->error != ERROR_NONE) {
+        p = put_text(p, "Lexical Error at line ");
+        p = put_uint(p, pos.line);
+        p = put_text(p, ": ");
+        if (shows_text(token->error) && text != NULL) {
+            p = put_text(p, error_message(token->error));
+            p = put_text(p, " '");
+            memcpy(p, text, token->length);
+            p += token->length;
+            *p++ = '\'';
+        } else {
+            p = put_text(p, error_message(token->error));
+        }
+    } else {
+        p = put_text(p, "Token: ");
+        p = put_text(p, token_type_name(token->type));
+        p = put_text(p, " | Lexeme: '");
+        // the decoded text goes straight into the block
+        p += lexeme_text(text, token, p, token->length + 4);
+        p = put_text(p, "' | Line: ");
+        p = put_uint(p, pos.line);
+    }
+    *p++ = '\n';
+    emitter->size = (size_t)(p - emitter->buffer);
+}
+
+static void emit_json_token(Emitter *emitter, const char *text, const Token *token, LinePos pos) {
+    long length = decode_lexeme(emitter, text, token);
+    char *p = length < 0 ? NULL : reserve(emitter, (size_t)length * 6 + RECORD_SLACK);
+    if (p == NULL) {
+        return;
+    }
+    p = put_text(p, "{\"type\":\"");
+    p = put_text(p, token_type_name(token->type));
+    if (token->error != ERROR_NONE) {
+        p = put_text(p, "\",\"error\":\"");
+        p = put_text(p, error_message(token->error));
+    }
+    p = put_text(p, "\",\"lexeme\":\"");
+    p = put_json_escaped(p, emitter->scratch, (size_t)length);
+    p = put_text(p, "\",\"line\":");
+    p = put_uint(p, pos.line);
+    p = put_text(p, ",\"column\":");
+    p = put_uint(p, pos.column);
+    p = put_text(p, ",\"start\":");
+    p = put_uint(p, token->start);
+    p = put_text(p, ",\"length\":");
+    p = put_uint(p, token->length);
+    if (has_value(token)) {
+        p = put_text(p, ",\"value\":");
+        p = put_value(p, token);
+    }
+    *p++ = '}';
+    *p++ = '\n';
+    emitter->size = (size_t)(p - emitter->buffer);
+}
+
+void emit_begin(Emitter *emitter) {
+    if (emitter->format == EMIT_CSV && !emitter->header_done) {
+        emitter->header_done = 1;
+        const char *header = "file,type,error,lexeme,line,column,start,length,value\n";
+        emit_raw(emitter, header, strlen(header));
+    }
+}
+
+static void emit_csv_token(Emitter *emitter, const char *text, const Token *token, LinePos pos) {
+    emit_begin(emitter);
+    const char *title = emitter->title != NULL ? emitter->title : "";
+    size_t title_length = strlen(title);
+    long length = decode_lexeme(emitter, text, token);
+    char *p = length < 0 ? NULL : reserve(emitter, ((size_t)length + title_length) * 2 + RECORD_SLACK);
+    if (p == NULL) {
+        return;
+    }
+    p = put_csv_quoted(p, title, title_length);
+    *p++ = ',';
+    p = put_text(p, token_type_name(token->type));
+    *p++ = ',';
+    if (token->error != ERROR_NONE) {
+        p = put_csv_quoted(p, error_message(token->error), strlen(error_message(token->error)));
+    }
+    *p++ = ',';
+    p = put_csv_quoted(p, emitter->scratch, (size_t)length);
+    *p++ = ',';
+    p = put_uint(p, pos.line);
+    *p++ = ',';
+    p = put_uint(p, pos.column);
+    *p++ = ',';
+    p = put_uint(p, token->start);
+    *p++ = ',';
+    p = put_uint(p, token->length);
+    *p++ = ',';
+    if (has_value(token)) {
+        p = put_value(p, token);
+    }
+    *p++ = '\n';
+    emitter->size = (size_t)(p - emitter->buffer);
+}
+
+static void emit_record(Emitter *emitter, const char *text, const Token *token, LinePos pos) {
+    switch (emitter->format) {
+        case EMIT_TEXT:
+            emit_text_token(emitter, text, token, pos);
+            break;
+        case EMIT_JSON:
+            emit_json_token(emitter, text, token, pos);
+            break;
+        case EMIT_CSV:
+            emit_csv_token(emitter, text, token, pos);
+            break;
+    }
+}
+
+/* An error token: written now, or held back for emit_diagnostics() */
+static void emit_error(Emitter *emitter, const char *text, const Token *token, LinePos pos) {
+    if (emitter->defer_errors) {
+        if (diagnostics_add(&emitter->diagnostics, token, pos) != 0) {
+            emitter->failed = 1;
+        }
+        return;
+    }
+    emit_record(emitter, text, token, pos);
+}
+
+/* The error for a bracket left unbalanced, reported with the bracket as its text */
+static void emit_bracket_error(Emitter *emitter, ErrorType error, const OpenBracket *bracket) {
+    Token token = {TOKEN_ERROR, error, (size_t)bracket->start, 1, SYMBOL_NONE, 0, {0}};
+    LinePos pos = {bracket->line, bracket->column};
+    emit_error(emitter, &bracket->bracket, &token, pos);
+}
+
+static void match_bracket(Emitter *emitter, char c, const Token *token, LinePos pos) {
+    OpenBracket here = {token->start, 0, (uint32_t)pos.line, (uint32_t)pos.column, c};
+    BracketStack *stack = &emitter->brackets;
+    size_t unclosed = 0;
+    switch (bracket_stack_match(stack, &here, &unclosed)) {
+        case BRACKET_OPENED:
+            break;
+        case BRACKET_MATCHED:
+            // the brackets opened inside this pair and not closed in it
+            for (size_t k = 1; k <= unclosed; k++) {
+                emit_bracket_error(emitter, ERROR_OPEN_DELIMITER, &stack->open[stack->depth + k]);
+            }
+            break;
+        case BRACKET_UNMATCHED:
+            emit_bracket_error(emitter, ERROR_UNMATCHED_DELIMITER, &here);
+            break;
+        case BRACKET_FAILED:
+            emitter->failed = 1;
+            break;
+    }
+}
+
+void emit_token_at(Emitter *emitter, const char *text, const Token *token, LinePos pos) {
+    if (token->error != ERROR_NONE) {
+        emit_error(emitter, text, token, pos);
+        return;
+    }
+    emit_record(emitter, text, token, pos);
+    if (token->type == TOKEN_DELIMITER && text != NULL && (bracket_opens(*text) || bracket_closes(*text))) {
+        match_bracket(emitter, *text, token, pos);
+    }
+}
+
+void emit_diagnostics(Emitter *emitter, const char *input) {
+    for (size_t i = 0; i < emitter->brackets.depth; i++) {
+        emit_bracket_error(emitter, ERROR_OPEN_DELIMITER, &emitter->brackets.open[i]);
+    }
+    emitter->brackets.depth = 0;
+
+    Diagnostics *diagnostics = &emitter->diagnostics;
+    diagnostics_sort(diagnostics);
+    for (size_t i = 0; i < diagnostics->count; i++) {
+        const Diagnostic *d = &diagnostics->items[i];
+        Token token = {TOKEN_ERROR, (ErrorType)d->kind, (size_t)d->start, d->length, SYMBOL_NONE, 0, {0}};
+        LinePos pos = {d->line, d->column};
+        emit_record(emitter, input != NULL ? input + token.start : NULL, &token, pos);
+    }
+
+    size_t dropped = diagnostics_dropped(diagnostics);
+    diagnostics_clear(diagnostics);
+    if (dropped == 0) {
+        return;
+    }
+    const char *title = emitter->title != NULL ? emitter->title : "";
+    size_t title_length = strlen(title);
+    char *p = reserve(emitter, title_length * 6 + RECORD_SLACK);
+    if (p == NULL) {
+        return;
+    }
+    switch (emitter->format) {
+        case EMIT_TEXT:
+            p = put_uint(p, dropped);
+            p = put_text(p, " more lexical errors not shown\n");
+            break;
+        case EMIT_JSON:
+            p = put_text(p, "{\"file\":\"");
+            p = put_json_escaped(p, title, title_length);
+            p = put_text(p, "\",\"errors_not_shown\":");
+            p = put_uint(p, dropped);
+            p = put_text(p, "}\n");
+            break;
+        case EMIT_CSV:
+            p = put_csv_quoted(p, title, title_length);
+            p = put_text(p, ",ERROR,\"");
+            p = put_uint(p, dropped);
+            p = put_text(p, " more lexical errors not shown\",\"\",0,0,0,0,\n");
+            break;
+    }
+    emitter->size = (size_t)(p - emitter->buffer);
+}
+
+void emit_token(Emitter *emitter, const char *input, const Token *token) {
+    LinePos pos = line_index_locate(emitter->lines, token->start, &emitter->line_hint);
+    emit_token_at(emitter, input + token->start, token, pos);
+}
+
+void emit_file_header(Emitter *emitter, const char *title, const char *source, size_t length) {
+    emitter->title = title;
+    size_t title_length = strlen(title);
+    // like printf("%s"), the echo stops at a NUL inside the file
+    length = emitter->echo ? strnlen(source, length) : 0;
+    char *p;
+    switch (emitter->format) {
+        case EMIT_TEXT:
+            p = reserve(emitter, title_length + 16);
+            if (p == NULL) {
+                return;
+            }
+            p = put_text(p, "Analyzing ");
+            p = put_text(p, title);
+            p = put_text(p, ":\n");
+            emitter->size = (size_t)(p - emitter->buffer);
+            if (emitter->echo) {
+                emit_raw(emitter, source, length);
+                emit_raw(emitter, "\n\n", 2);
+            }
+            break;
+        case EMIT_JSON:
+            p = reserve(emitter, (title_length + length) * 6 + 32);
+            if (p == NULL) {
+                return;
+            }
+            p = put_text(p, "{\"file\":\"");
+            p = put_json_escaped(p, title, title_length);
+            if (emitter->echo) {
+                p = put_text(p, "\",\"source\":\"");
+                p = put_json_escaped(p, source, length);
+            }
+            p = put_text(p, "\"}\n");
+            emitter->size = (size_t)(p - emitter->buffer);
+            break;
+        case EMIT_CSV:
+            emit_begin(emitter);  // CSV has no place for the source
+            break;
+    }
+}
+
+void emit_open_error(Emitter *emitter, const char *title) {
+    const char *message = "Error opening file";
+    size_t title_length = strlen(title);
+    char *p;
+    switch (emitter->format) {
+        case EMIT_TEXT:
+            emit_raw(emitter, "Error opening file\n", 19);
+            break;
+        case EMIT_JSON:
+            p = reserve(emitter, title_length * 6 + 64);
+            if (p == NULL) {
+                return;
+            }
+            p = put_text(p, "{\"file\":\"");
+            p = put_json_escaped(p, title, title_length);
+            p = put_text(p, "\",\"error\":\"");
+            p = put_text(p, message);
+            p = put_text(p, "\"}\n");
+            emitter->size = (size_t)(p - emitter->buffer);
+            break;
+        case EMIT_CSV:
+            emit_begin(emitter);
+            p = reserve(emitter, title_length * 2 + 64);
+            if (p == NULL) {
+                return;
+            }
+            p = put_csv_quoted(p, title, title_length);
+            p = put_text(p, ",ERROR,");
+            p = put_csv_quoted(p, message, strlen(message));
+            p = put_text(p, ",\"\",0,0,0,0,\n");
+            emitter->size = (size_t)(p - emitter->buffer);
+            break;
+    }
+}
+
+char *emitter_take(Emitter *emitter, size_t *length) {
+    char *buffer = emitter->buffer;
+    *length = emitter->size;
+    emitter->buffer = NULL;
+    emitter->size = 0;
+    emitter->capacity = 0;
+    return buffer;
+}
+
+int emitter_close(Emitter *emitter) {
+    int result = emitter_flush(emitter);
+    free(emitter->buffer);
+    free(emitter->scratch);
+    diagnostics_free(&emitter->diagnostics);
+    bracket_stack_free(&emitter->brackets);
+    emitter->buffer = NULL;
+    emitter->scratch = NULL;
+    return result;
+}
@@ -0,0 +1,155 @@
+/* incremental.c
+ * Re-lexing only the tokens an edit touches.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/incremental.h"
+
+/* Bytes the scanner may read past the end of a token (the operator table reads 3 bytes from
+ * its start). A token ending this far before an edit was scanned from unchanged text. */
+#define EDIT_MARGIN 4
+
+/* Does the lexer state after token i depend only on where the token ends? Only an operator,
+ * or a consecutive-operator error that keeps the operator before it, makes the next token
+ * behave differently. */
+static inline int settles_lexer(const TokenStream *tokens, size_t i) {
+    return tokens->errors[i] == ERROR_NONE && tokens->kinds[i] != TOKEN_OPERATOR &&
+           tokens->kinds[i] != TOKEN_EOF;
+}
+
+static inline int settles_token(const Token *token) {
+    return token->error == ERROR_NONE && token->type != TOKEN_OPERATOR && token->type != TOKEN_EOF;
+}
+
+/* Number of leading tokens that end at least EDIT_MARGIN bytes before offset */
+static size_t tokens_before(const TokenStream *tokens, size_t offset) {
+    size_t low = 0, high = tokens->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if ((size_t)tokens->starts[mid] + tokens->lengths[mid] + EDIT_MARGIN <= offset) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/* Is the new token the old token i, moved by shift bytes? */
+static inline int same_moved(const TokenStream *tokens, size_t i, const Token *token, long long shift) {
+    return (long long)tokens->starts[i] + shift == (long long)token->start &&
+           tokens->lengths[i] == token->length && tokens->kinds[i] == (unsigned char)token->type &&
+           tokens->errors[i] == (unsigned char)token->error;
+}
+
+/* Move count entries of every column from index from to index to */
+static void move_tokens(TokenStream *tokens, size_t from, size_t to, size_t count) {
+    memmove(tokens->kinds + to, tokens->kinds + from, count);
+    memmove(tokens->errors + to, tokens->errors + from, count);
+    memmove(tokens->flags + to, tokens->flags + from, count);
+    memmove(tokens->starts + to, tokens->starts + from, count * sizeof(uint32_t));
+    memmove(tokens->lengths + to, tokens->lengths + from, count * sizeof(uint32_t));
+    memmove(tokens->symbols + to, tokens->symbols + from, count * sizeof(uint32_t));
+    memmove(tokens->values + to, tokens->values + from, count * sizeof(uint64_t));
+}
+
+int lex_update(TokenStream *tokens, const char *input, size_t length, const LexEdit *edit,
+               const LexerOptions *options, LexChange *change) {
+    if (length > TOKEN_STREAM_MAX_INPUT || tokens->count == 0) {
+        return -1;
+    }
+    long long shift = (long long)edit->inserted - (long long)edit->deleted;
+    size_t new_edit_end = edit->offset + edit->inserted;
+
+    // restart after the last token that is clear of the edit and settles the lexer
+    size_t keep = tokens_before(tokens, edit->offset);
+    while (keep > 0 && !settles_lexer(tokens, keep - 1)) {
+        keep--;
+    }
+    Lexer lexer;
+    lexer_init(&lexer, input, length, options);
+    if (keep > 0) {
+        lexer.pos = (size_t)tokens->starts[keep - 1] + tokens->lengths[keep - 1];
+    }
+
+    // lex until a new token past the edit lines up with an old one that settles the lexer;
+    // from there on both streams see the same text in the same state
+    size_t capacity = 64, count = 0;
+    Token *fresh = malloc(capacity * sizeof(Token));
+    size_t old = keep, synced = tokens->count;
+    while (fresh != NULL) {
+        if (count == capacity) {
+            capacity *= 2;
+            Token *grown = realloc(fresh, capacity * sizeof(Token));
+            if (!grown) {
+                free(fresh);
+                fresh = NULL;
+                break;
+            }
+            fresh = grown;
+        }
+        Token token = get_next_token(&lexer);
+        fresh[count++] = token;
+        if (token.type == TOKEN_EOF) {
+            break;
+        }
+        if (token.start < new_edit_end || !settles_token(&token)) {
+            continue;
+        }
+        size_t old_start = (size_t)((long long)token.start - shift);  // past the edit in the old text too
+        while (old < tokens->count && tokens->starts[old] < old_start) {
+            old++;
+        }
+        if (old < tokens->count && same_moved(tokens, old, &token, shift) && settles_lexer(tokens, old)) {
+            synced = old;
+            break;
+        }
+    }
+    if (fresh == NULL) {
+        return -1;
+    }
+
+    // old tokens [keep, old_end) become fresh[0, count); the synced token is in both
+    size_t old_end = synced < tokens->count ? synced + 1 : tokens->count;
+    size_t total = keep + count + (tokens->count - old_end);
+    if (token_stream_reserve(tokens, total) != 0) {
+        free(fresh);
+        return -1;
+    }
+
+    // trim what the fresh tokens share with the old ones, to report only the real change:
+    // tokens wholly before or after the edit that came out the same
+    size_t first = 0, last = count;
+    while (first < last && keep + first < old_end && fresh[first].start + fresh[first].length <= edit->offset &&
+           same_moved(tokens, keep + first, &fresh[first], 0)) {
+        first++;
+    }
+    size_t old_last = old_end;
+    while (last > first && old_last > keep + first && fresh[last - 1].start >= new_edit_end &&
+           same_moved(tokens, old_last - 1, &fresh[last - 1], shift)) {
+        last--;
+        old_last--;
+    }
+
+    move_tokens(tokens, old_end, keep + count, tokens->count - old_end);
+    for (size_t i = 0; i < count; i++) {
+        size_t to = keep + i;
+        tokens->kinds[to] = (unsigned char)fresh[i].type;
+        tokens->errors[to] = (unsigned char)fresh[i].error;
+        tokens->flags[to] = (unsigned char)fresh[i].flags;
+        tokens->starts[to] = (uint32_t)fresh[i].start;
+        tokens->lengths[to] = (uint32_t)fresh[i].length;
+        tokens->symbols[to] = fresh[i].symbol;
+        tokens->values[to] = fresh[i].value.integer;
+    }
+    for (size_t i = keep + count; i < total; i++) {
+        tokens->starts[i] = (uint32_t)((long long)tokens->starts[i] + shift);
+    }
+    tokens->count = total;
+    free(fresh);
+
+    change->first = keep + first;
+    change->old_end = old_last;
+    change->new_end = keep + last;
+    return 0;
+}
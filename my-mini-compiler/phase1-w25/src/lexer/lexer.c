@@ -2,694 +2,616 @@
 /* lexer.c */
 #include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
 #include <string.h>
 #include "../../include/tokens.h"
 #include "../../include/keywords.h"
+#include "../../include/lexer.h"
+#include "../../include/token_stream.h"
+#include "../../include/skip.h"
+#include "../../include/number.h"
+#include "scanner_tables.h"  // generated at build time by tools/gen_scanner.c
+
+/* Map the character after a backslash to the character it stands for, '\0' if it is not a valid escape */
+static char decode_escape(char c_escape) {
+    switch (c_escape) {
+        case '\\':
+        case '\'':
+        case '\"':
+            // characters that are on their own
+            return c_escape;
+        case 'n':
+            return '\n';   // newline
+        case 'r':
+            return '\r';   // carriage return
+        case 't':
+            return '\t';   // tab
+        default:
+            return '\0';   // unrecognized escape character
+    }
+}
 
-// Line tracking
-static int current_line = 1;
-static char last_token_type = 'y'; // For checking consecutive operators
+/* Decode the literal text src[0, length) into out as token_text() does */
+static size_t decode_literal(const char *src, size_t length, char *out, size_t out_size) {
+    size_t n = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = src[i];
+        if (c == '\\' && i + 1 < length && decode_escape(src[i + 1]) != '\0') {
+            c = decode_escape(src[++i]);
+        } else if (c == '\r') {
+            // a raw \r\n or lone \r line break inside a literal reads as \n
+            if (i + 1 < length && src[i + 1] == '\n') {
+                i++;
+            }
+            c = '\n';
+        }
+        if (n + 1 < out_size) {
+            out[n] = c;
+        }
+        n++;
+    }
+    if (out_size > 0) {
+        out[n < out_size ? n : out_size - 1] = '\0';
+    }
+    return n;
+}
 
-/* Print error messages for lexical errors */
-void print_error(ErrorType error, int line, const char *lexeme) {
-    printf("Lexical Error at line %d: ", line);
-    switch (error) {
-        case ERROR_INVALID_CHAR:
-            printf("Invalid character '%s'\n", lexeme);
-            break;
-        case ERROR_INVALID_NUMBER:
-            printf("Invalid number format\n");
-            break;
-        case ERROR_CONSECUTIVE_OPERATORS:
-            printf("Consecutive operators not allowed\n");
-            break;
-        case ERROR_STRING_OVERFLOW:
-            printf("Overflow in string\n");
-            break;
-        case ERROR_UNTERMINATED_STRING:
-            printf("Unterminated string\n");
-            break;
-        case ERROR_INVALID_ESCAPE_CHARACTER:
-            printf("Unrecognized/invalid escape character\n");
-            break;
-        case ERROR_UNTERMINATED_CHARACTER:
-            printf("Unterminated character\n");
-            break;
-        case ERROR_OPEN_DELIMITER:
-            printf("Unclosed brackets\n");
-            break;
-        default:
-            printf("Unknown error\n");
+/* Decode the text of a token from its span in the source buffer.
+ * Writes at most out_size - 1 characters plus a '\0' and returns the full decoded length,
+ * so a caller can size its buffer with token_text(input, token, NULL, 0) + 1.
+ * String literals keep their quotes, char literals give just the character and
+ * escape sequences in both are decoded (invalid ones are kept as written) and raw
+ * \r\n or \r line breaks come out as \n. Tokens without TOKEN_FLAG_ESCAPES are copied
+ * as they are.
+ */
+size_t token_text(const char *input, const Token *token, char *out, size_t out_size) {
+    const char *src = input + token->start;
+    size_t length = token->length;
+
+    if (token->type == TOKEN_EOF) {
+        src = "EOF";
+        length = 3;
+    }
+    int literal = token->error == ERROR_NONE &&
+        (token->type == TOKEN_STRING_LITERAL || token->type == TOKEN_CHAR_LITERAL);
+    size_t i = 0;
+    if (literal && token->type == TOKEN_CHAR_LITERAL) {
+        // drop the surrounding quotes
+        i = 1;
+        length--;
+    }
+
+    if (literal && (token->flags & TOKEN_FLAG_ESCAPES)) {
+        return decode_literal(src + i, length - i, out, out_size);
     }
+    size_t n = length - i;
+    if (out_size > 0) {
+        size_t copy = n < out_size ? n : out_size - 1;
+        memcpy(out, src + i, copy);
+        out[copy] = '\0';
+    }
+    return n;
 }
 
-/* Print token information */
-void print_token(Token token) {
-    if (token.error != ERROR_NONE) {
-        print_error(token.error, token.line, token.lexeme);
+const char *token_literal(Arena *arena, const char *input, const Token *token, size_t *length) {
+    const char *src = input + token->start + 1;
+    size_t raw = token->length - 2;
+    if (!(token->flags & TOKEN_FLAG_ESCAPES)) {
+        *length = raw;
+        return src;
+    }
+    // decoding never makes the text longer
+    char *out = arena_alloc(arena, raw + 1);
+    if (!out) {
+        return NULL;
+    }
+    *length = decode_literal(src, raw, out, raw + 1);
+    return out;
+}
+
+/* Print the decoded text of a token, without any length limit */
+static void print_lexeme(FILE *out, const char *input, const Token *token) {
+    char small[128];
+    size_t length = token_text(input, token, small, sizeof(small));
+    if (length < sizeof(small)) {
+        fwrite(small, 1, length, out);
         return;
     }
+    char *text = malloc(length + 1);
+    if (!text) {
+        return;
+    }
+    token_text(input, token, text, length + 1);
+    fwrite(text, 1, length, out);
+    free(text);
+}
 
-    printf("Token: ");
-    switch (token.type) {
-        case TOKEN_NUMBER:
-            printf("NUMBER");
-            break;
-        case TOKEN_OPERATOR:
-            printf("OPERATOR");
-            break;
-        case TOKEN_EOF:
-            printf("EOF");
-            break;
-        case TOKEN_KEYWORD:
-            printf("KEYWORD");
-            break;
-        case TOKEN_IDENTIFIER:
-            printf("IDENTIFIER");
-            break;
-        case TOKEN_STRING_LITERAL:
-            printf("STRING_LITERAL");
-            break;
-        case TOKEN_CHAR_LITERAL:
-            printf("CHAR_LITERAL");
-            break;
-        case TOKEN_DELIMITER:
-            printf("DELIMITER");
-            break;
-        case TOKEN_SPECIAL_CHARACTER:
-            printf("SPECIAL_CHARACTER");
-            break;
-        default:
-            printf("UNKNOWN");
+static const char *const error_messages[] = {
+    [ERROR_NONE] = "No error",
+    [ERROR_INVALID_CHAR] = "Invalid character",
+    [ERROR_INVALID_NUMBER] = "Invalid number format",
+    [ERROR_CONSECUTIVE_OPERATORS] = "Consecutive operators not allowed",
+    [ERROR_STRING_OVERFLOW] = "Overflow in string",
+    [ERROR_UNTERMINATED_STRING] = "Unterminated string",
+    [ERROR_INVALID_ESCAPE_CHARACTER] = "Unrecognized/invalid escape character",
+    [ERROR_UNTERMINATED_CHARACTER] = "Unterminated character",
+    [ERROR_OPEN_DELIMITER] = "Unclosed bracket",
+    [ERROR_TOKEN_OVERFLOW] = "Token longer than the input window",
+    [ERROR_UNMATCHED_DELIMITER] = "Unmatched closing bracket",
+};
+
+static const char *const type_names[] = {
+    [TOKEN_EOF] = "EOF",
+    [TOKEN_NUMBER] = "NUMBER",
+    [TOKEN_OPERATOR] = "OPERATOR",
+    [TOKEN_ERROR] = "ERROR",
+    [TOKEN_KEYWORD] = "KEYWORD",
+    [TOKEN_IDENTIFIER] = "IDENTIFIER",
+    [TOKEN_STRING_LITERAL] = "STRING_LITERAL",
+    [TOKEN_CHAR_LITERAL] = "CHAR_LITERAL",
+    [TOKEN_DELIMITER] = "DELIMITER",
+    [TOKEN_SPECIAL_CHARACTER] = "SPECIAL_CHARACTER",
+    [TOKEN_FLOAT] = "FLOAT",
+};
+
+const char *error_message(ErrorType error) {
+    if ((unsigned int)error < sizeof(error_messages) / sizeof(error_messages[0])) {
+        return error_messages[error];
     }
-    printf(" | Lexeme: '%s' | Line: %d\n", token.lexeme, token.line);
+    return "Unknown error";
 }
 
-/* Get next token from input */
-Token get_next_token(const char *input, int *pos) {
-    Token token = {TOKEN_ERROR, "", current_line, ERROR_NONE};
-    char c;
-
-    // Skip whitespace and track line numbers
-    while ((c = input[*pos]) != '\0' && (c == ' ' || c == '\n' || c == '\t')) {
-        if (c == '\n') {
-            current_line++;
-        }
-        (*pos)++;
+const char *token_type_name(TokenType type) {
+    if ((unsigned int)type < sizeof(type_names) / sizeof(type_names[0])) {
+        return type_names[type];
     }
+    return "UNKNOWN";
+}
 
-    // Check for end of file
-    if (input[*pos] == '\0') {
-        token.type = TOKEN_EOF;
-        strcpy(token.lexeme, "EOF");
-        return token;
+/* Print error messages for lexical errors */
+void fprint_error(FILE *out, const char *input, const LineIndex *lines, const Token *token) {
+    LinePos pos = line_index_locate(lines, token->start, NULL);
+    fprintf(out, "Lexical Error at line %zu: ", pos.line);
+    if (token->error == ERROR_INVALID_CHAR) {
+        fprintf(out, "Invalid character '%.*s'\n", (int)token->length, input + token->start);
+    } else {
+        fprintf(out, "%s\n", error_message(token->error));
     }
+}
 
-    // get current character
-    c = input[*pos];
+/* Print token information */
+void fprint_token(FILE *out, const char *input, const LineIndex *lines, const Token *token) {
+    if (token->error != ERROR_NONE) {
+        fprint_error(out, input, lines, token);
+        return;
+    }
 
-    // Comment handler
-    // Single line comment
-    if (c == '#') {
-        do{
-            (*pos)++;
-            c = input[*pos];
-        } while(c != '\n');
-        //skip newline character
-        (*pos)++;
-        c = input[*pos];
+    fprintf(out, "Token: %s | Lexeme: '", token_type_name(token->type));
+    print_lexeme(out, input, token);
+    fprintf(out, "' | Line: %zu\n", line_index_locate(lines, token->start, NULL).line);
+}
+
+void print_token(const char *input, const LineIndex *lines, const Token *token) {
+    fprint_token(stdout, input, lines, token);
+}
+
+void print_error(const char *input, const LineIndex *lines, const Token *token) {
+    fprint_error(stdout, input, lines, token);
+}
 
-        while(c == ' ' || c == '\t' || c == '\n'  && c != '\0'){
-            (*pos)++;
-            c = input[*pos];
+/* Advance up to count characters from pos, stopping early at a line break or the end of input
+ * so error recovery never swallows the next line's first token */
+static size_t skip_in_line(const char *input, size_t length, size_t pos, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (pos >= length || input[pos] == '\n' || input[pos] == '\r') {
+            break;
         }
+        pos++;
     }
+    return pos;
+}
 
-    // Multi line comment
-    // should skip until */ is reached
-    if (c == '/' && input[*pos + 1] == '*') {
-        (*pos)++; // skip /
-        // c = input[*pos];
-        do{
-            (*pos)++; //move ahead (will also skip asterisk in /*)
-            c = input[*pos];
-            if (c == '\0') {
-                printf("[WARN]: Unclosed comment\n");
-                break;
-            }
-        }while((c != '*') && (input[*pos + 1] != '/'));
-        (*pos)+=2; // move ahead of */
-        c = input[*pos];
-        //skip to start of next token
-        while(c == ' ' || c == '\t' || c == '\n'  && c != '\0'){
-            (*pos)++;
-            c = input[*pos];
+/* Finish a string literal starting at the opening quote at lexer->pos.
+ * Plain text is skipped a vector at a time up to the next quote, backslash or '\r' */
+static void scan_string(Lexer *lexer, Token *token) {
+    const char *input = lexer->input;
+    const char *input_end = input + lexer->length;
+    const char *p = input + lexer->pos + 1;
+
+    for (;;) {
+        p = find_string_stop(p, input_end);
+        // closing quotation case
+        if (*p == '\"') {
+            token->type = TOKEN_STRING_LITERAL;
+            lexer->last_token_type = 's'; //string
+            p++;
+            break;
         }
+        // end of file means unterminated
+        if (p == input_end) {
+            token->error = ERROR_UNTERMINATED_STRING;
+            lexer->last_token_type = 'e'; //error
+            break;
+        }
+        // escapes and raw \r line breaks are only validated here, token_text() decodes them
+        token->flags |= TOKEN_FLAG_ESCAPES;
+        if (*p == '\r') {
+            p++;
+            continue;
+        }
+        if (p + 1 == input_end) {
+            // leave the end of input for the unterminated check
+            p++;
+            continue;
+        }
+        if (decode_escape(p[1]) == '\0') {
+            // unrecognized escape character
+            token->error = ERROR_INVALID_ESCAPE_CHARACTER;
+            lexer->last_token_type = 'e'; // error
+        }
+        p += 2;
     }
+    lexer->pos = (size_t)(p - input);
+}
 
-    // Number handler
-    if (isdigit(c)) {
-        int i = 0;
-        do {
-            token.lexeme[i++] = c;
-            (*pos)++;
-            c = input[*pos];
-        } while (isdigit(c) && i < sizeof(token.lexeme) - 1);
+/* Finish a char literal starting at the opening quote at lexer->pos */
+static void scan_char(Lexer *lexer, Token *token) {
+    const char *input = lexer->input;
+    size_t length = lexer->length;
+    size_t *pos = &lexer->pos;
+
+    // following character should be an escape character
+    char c_char = input[*pos+1];
+    if(c_char == '\\') {
+        // check it gets closed, if not skip 4 characters and continue
+        if (*pos + 2 >= length || input[*pos+3] != '\'') {
+            token->error = ERROR_UNTERMINATED_CHARACTER;
+            lexer->last_token_type = 'e'; //error
+            *pos = skip_in_line(input, length, *pos, 4);
+            return;
+        }
+        // only escape characters supported by the system are accepted
+        if (decode_escape(input[*pos+2]) == '\0') {
+            // unrecognized escape character
+            token->error = ERROR_INVALID_ESCAPE_CHARACTER;
+            lexer->last_token_type = 'e'; // error
+            (*pos) += 4;
+            return;
+        }
+        token->type = TOKEN_CHAR_LITERAL;
+        token->flags |= TOKEN_FLAG_ESCAPES;
+        lexer->last_token_type = 'x'; // escape char
+        (*pos) += 4;
+        return;
+    }
 
-        token.lexeme[i] = '\0';
-        token.type = TOKEN_NUMBER;
-        last_token_type = 'n'; //number
-        return token;
+    // unterminated character
+    if (*pos + 1 >= length || input[*pos+2] != '\'') {
+        token->error = ERROR_UNTERMINATED_CHARACTER;
+        lexer->last_token_type = 'e'; // error
+        *pos = skip_in_line(input, length, *pos, 3);
     }
+    else {  // any valid character
+        token->type = TOKEN_CHAR_LITERAL;
+        if (c_char == '\r') {
+            token->flags |= TOKEN_FLAG_ESCAPES;  // reads as '\n'
+        }
+        *pos += 3;
+        lexer->last_token_type = 'c'; // char
+    }
+}
+
+static inline int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
 
-    // Keyword and Identifier handler
-    if(isalpha(c) || (c == '_' && isalnum(input[*pos + 1]))){
-        int i = 0;
-        do{
-            token.lexeme[i++] = c;
-            (*pos)++;
-            c = input[*pos];
-        } while((isalnum(c) || c == '_') && i < sizeof(token.lexeme) - 1); // numbers and _ are valid in identifiers
-        // Terminate string
-        token.lexeme[i] = '\0';
-
-        if(iskeyword(token.lexeme)){
-            token.type = TOKEN_KEYWORD;
-            last_token_type = 'k'; //keyword
+/* Finish a number literal whose leading digits are [p, end): a fraction ('.' and digits) or
+ * an exponent (e or E, an optional sign and digits) after them make it a float. Neither is
+ * taken unless it is complete, so "1." and "1e" stay a number followed by other tokens.
+ * Returns the end of the literal */
+static const char *scan_number(const char *p, const char *end, Token *token) {
+    const char *digits_end = end;
+    if (end[0] == '.' && is_digit(end[1])) {
+        end += 2;
+        while (is_digit(*end)) {
+            end++;
         }
-        else{
-            token.type = TOKEN_IDENTIFIER;
-            last_token_type = 'i'; //identifier
+    }
+    if (end[0] == 'e' || end[0] == 'E') {
+        const char *e = end + 1;
+        if (*e == '+' || *e == '-') {
+            e++;
+        }
+        if (is_digit(*e)) {
+            while (is_digit(*e)) {
+                e++;
+            }
+            end = e;
         }
-        return token;
     }
 
-    // Special character handler
-    if((c == '&' && input[*pos + 1] != '&') || c == '_') {
-        token.lexeme[0] = c;
-        token.lexeme[1] = '\0';
-        token.type = TOKEN_SPECIAL_CHARACTER;
-        (*pos)++;
-        last_token_type = 'z'; //special character
-        return token;
+    int failed;
+    if (end == digits_end) {
+        token->type = TOKEN_NUMBER;
+        failed = parse_integer(p, (size_t)(end - p), &token->value.integer);
+    } else {
+        token->type = TOKEN_FLOAT;
+        failed = parse_float(p, (size_t)(end - p), &token->value.real);
     }
+    if (failed) {
+        // too large for its type
+        token->type = TOKEN_ERROR;
+        token->error = ERROR_INVALID_NUMBER;
+        token->value.integer = 0;
+    }
+    return end;
+}
 
-    // String literal handler
-    if(c == '"'){
-        int i = 0;
-        token.lexeme[i++] = c;
-        (*pos)++;
-        do{
-            // check to see if string is too long (above 100 characters)
-            if(i >= sizeof(token.lexeme) - 1) {
-                token.error = ERROR_STRING_OVERFLOW;
-                token.lexeme[i] = '\0';
-                last_token_type = 'e'; // error
-                (*pos)++;
-                char overflow = input[*pos];
-                // continues until the string is closed, just doesn't save the string data anymore
-                while(overflow != '\"') {
-                    // have to check for EOF to ensure string is terminated at some point
-                    if (input[*pos] == '\0') {
-                        token.error = ERROR_UNTERMINATED_STRING;
-                        break;
-                    }
-                    // continue to track but not save
-                    overflow = input[*pos];
-                    (*pos)++;
-                }
-                break;
-            }
-            // get character for comparison
-            char c_string = input[*pos];
-            // closing quotation case
-            if (c_string == '\"') {
-                token.lexeme[i++] = c_string;
-                token.lexeme[i] = '\0';
-                token.type = TOKEN_STRING_LITERAL;
-                last_token_type = 's'; //string
-                (*pos)++;
-                break;
-            }
-            // end of file means unterminated
-            if (c_string == '\0') {
-                token.error = ERROR_UNTERMINATED_STRING;
-                token.lexeme[i] = '\0';
-                last_token_type = 'e'; //error
-                break;
-            }
-            // case of escape character
-            if (c_string == '\\' && i <= sizeof(token.lexeme) - 1) {
-                // introduces niche case of the character that overflows the token size, might need its own handler
-                char c_escape = input[*pos+1];
-                switch (c_escape) {
-                    case '\\':
-                    case '\'':
-                    case '\"':
-                        // characters that are on their own
-                        token.lexeme[i++] = c_escape;
-                        (*pos) += 2;
-                        break;
-                    case 'n':
-                        // newline
-                        token.lexeme[i++] = '\n';
-                        (*pos) += 2;
-                        break;
-                    case 'r':
-                        // carriage return
-                        token.lexeme[i++] = '\r';
-                        (*pos) += 2;
-                        break;
-                    case 't':
-                        // tab
-                        token.lexeme[i++] = '\t';
-                        (*pos) += 2;
-                        break;
-                    default:
-                        // unrecognized escape character
-                        token.error = ERROR_INVALID_ESCAPE_CHARACTER;
-                        token.lexeme[i++] = c_string;
-                        token.lexeme[i++] = c_escape;
-                        last_token_type = 'e'; // error
-                        (*pos) += 2;
-                        break;
-                }
-            } else { // case of any valid character
-                token.lexeme[i++] = c_string;
-                (*pos)++;
-            }
-        } while(1);
+/* Scan the next token, get_next_token() fills in its length.
+ * The token rules live in tokens.spec: the DFA generated from it finds the longest rule
+ * matching at the current position, one table lookup per byte, and the rule's action
+ * finishes the token.
+ */
+int token_can_start(char c) {
+    unsigned char u = (unsigned char)c;
+    return scan_op_class[u] != 0 || scan_next[SCAN_START][scan_class[u]] != 0;
+}
 
-        // returning
-        return token;
-    }
+static inline Token scan_token(Lexer *lexer) {
+    const char *input = lexer->input;
+    const char *input_end = input + lexer->length;
+    size_t *pos = &lexer->pos;
+    Token token = {TOKEN_ERROR, ERROR_NONE, 0, 0, SYMBOL_NONE, 0, {0}};
+    const char *p = input + *pos;
 
-    // char literal handler
-    if(c == '\''){
-        // following character should be an escape character
-        char c_char = input[*pos+1];
-        if(c_char == '\\') {
-            // check it gets closed, if not skip 4 characters and continue
-            if (input[*pos+3] != '\'') {
-                token.error = ERROR_UNTERMINATED_CHARACTER;
-                token.lexeme[0] = c_char;
-                token.lexeme[1] = '\0';
-                last_token_type = 'e'; //error
-                (*pos) += 4;
-                return token;
-            }
-            // case block for all escape characters supported by the system
-            char c_escape = input[*pos+2];
-            switch (c_escape) {
-                case '\\':
-                case '\'':
-                case '\"':
-                    // basic escape chars
-                    token.lexeme[0] = c_escape;
-                    token.lexeme[1] = '\0';
-                    break;
-                case 'n':
-                    // newline
-                    token.lexeme[0] = '\n';
-                    token.lexeme[1] = '\0';
-                    break;
-                case 'r':
-                    // carriage return
-                    token.lexeme[0] = '\r';
-                    token.lexeme[1] = '\0';
-                    break;
-                case 't':
-                    // tab
-                    token.lexeme[0] = '\t';
-                    token.lexeme[1] = '\0';
-                    break;
-                default:
-                    // unrecognized escape character
-                    token.error = ERROR_INVALID_ESCAPE_CHARACTER;
-                    last_token_type = 'e'; // error
-                    (*pos) += 4;
-                    return token;
-            }
-            token.type = TOKEN_CHAR_LITERAL;
-            last_token_type = 'x'; // escape char
-            (*pos) += 4;
+    for (;;) {
+        token.start = (size_t)(p - input);
+        *pos = token.start;
+
+        // Check for end of file: only the end of the buffer, a NUL before it is an invalid character
+        if (p == input_end) {
+            token.type = TOKEN_EOF;
             return token;
         }
 
-        // unterminated character
-        if (input[*pos+2] != '\'') {
-            token.error = ERROR_UNTERMINATED_CHARACTER;
-            last_token_type = 'e'; // error
-            (*pos) += 3;
-        }
-        else {  // any valid character
-            token.lexeme[0] = c_char;
-            token.lexeme[1] = '\0';
-            token.type = TOKEN_CHAR_LITERAL;
-            *pos += 3;
-            last_token_type = 'c'; // char
+        // Operators: the longest one starting here is a single load keyed on the next three bytes
+        unsigned int first = scan_op_class[(unsigned char)p[0]];
+        if (first != 0) {
+            unsigned int second = scan_op_class[(unsigned char)p[1]];
+            unsigned int third = p[1] != '\0' ? scan_op_class[(unsigned char)p[2]] : 0;
+            unsigned int op = scan_op[(first * SCAN_OP_CLASSES + second) * SCAN_OP_CLASSES + third];
+            if (op != 0) {
+                // Check for consecutive operators
+                if (lexer->last_token_type == 'o' && !scan_follows_operator[(unsigned char)*p]) {
+                    token.error = ERROR_CONSECUTIVE_OPERATORS;
+                    (*pos)++;
+                    return token;
+                }
+                token.type = TOKEN_OPERATOR;
+                *pos += scan_rules[op - 1].length;
+                lexer->last_token_type = scan_rules[op - 1].last_type;
+                return token;
+            }
         }
-        // the char literal handler can finally return
-        return token;
-    }
 
-    /* List of Operators (Grouped by first character and behaviour):
-    //RULE: Standalone
-    $:  $ (factorial)
-
-    //RULE: Can be trailed by one repetition or an equals sign
-    +:  + (add), ++ (increment), += (add-assign)
-    -:  - (sub), -- (decrement), -= (sub-assign)
-
-    //RULE: Can be trailed only by an equals sign
-    *:  * (multiply), *= (multiply-assign)      NOTE: ** not an op
-    /:  / (divide), /= (divide-assign)        NOTE: // is meaningless
-    %:  % (modulo), %= (mod-assign)
-    =:  = (assignment), == (logic eq)
-    !:  ! (bitwise not), != (logic not)
-
-    //RULE: Can be trailed only by itself
-    |:  | (bitwise or), || (logical or)
-    ^:  ^ (bitwise xor), ^^ (power)
-
-    //RULE: Can be trailed by itself or question mark and CANT standalone
-    &:  && (logical and), &? (bitwise and)   NOTE: & is a special char
-    
-    //RULE: Can repeat 3 times or be trailed by an equals sign
-    <:  < (less), <= (less or equal), << (shift left), <<< (rotate left)
-    >:  > (greater), >= (greater or equal), >> (shift right), >>> (rotate right)
-    */
-    // Operator handler
-    if (c == '$' || c == '+' || c == '-' || c == '*' || c == '/'
-        || c == '%' || c == '=' || c == '!'  || c == '|'
-        || c == '^' || c == '&' || c == '<' || c== '>') {
-        // Check for consecutive operators
-        if (last_token_type == 'o' && c != '!' && c != '$') {
-            token.error = ERROR_CONSECUTIVE_OPERATORS;
-            token.lexeme[0] = c;
-            token.lexeme[1] = '\0';
-            (*pos)++;
+        // Longest match: run the DFA until it dies. gen_scanner makes sure every state past
+        // the start accepts, so the last live state names the rule and nothing is re-read.
+        // The keyword hash runs alongside: it is off the state chain, so it costs next to
+        // nothing for the other rules and an identifier is never walked a second time
+        const unsigned char *q = (const unsigned char *)p;
+        unsigned int state = SCAN_START, next;
+        unsigned int hash = KEYWORD_HASH_INIT;
+        while ((next = scan_next[state][scan_class[*q]]) != 0) {
+            state = next;
+            hash = KEYWORD_HASH_STEP(hash, *q);
+            q++;
+        }
+        const char *end = (const char *)q;
+        int rule = scan_accept[state] - 1;
+
+        // Handle invalid characters: the whole run of bytes that cannot start a token is one
+        // error, so binary junk costs a vector scan instead of an error per byte
+        if (rule < 0) {
+            token.error = ERROR_INVALID_CHAR;
+            lexer->last_token_type = 'e'; //error
+            p++;
+            for (;;) {
+                p = skip_binary(p, input_end);
+                if (p == input_end || token_can_start(*p)) {
+                    break;
+                }
+                p++;
+            }
+            *pos = (size_t)(p - input);
             return token;
         }
 
-        //Determine first-char logic
-        char c_next = input[*pos + 1]; // c_next should always be in array bound, if passed in string was completed with a null terminal.
-        switch (c) {
-            //Can be trailed by one repetition or an equals sign
-            case '+':
-            case '-':
-                if (c_next == '=') {
-                    // += and -= cases
-                    token.lexeme[0] = c;
-                    token.lexeme[1] = c_next;
-                    token.lexeme[2] = '\0';
-                    token.type = TOKEN_OPERATOR;
-                    *pos += 2;
-                    last_token_type = 'q'; // equals
-                } else if(c_next == c) {
-                    // ++ and -- cases
-                    token.lexeme[0] = c;
-                    token.lexeme[1] = c_next;
-                    token.lexeme[2] = '\0';
-                    token.type = TOKEN_OPERATOR;
-                    *pos += 2;
-                    last_token_type = 'o'; // operator
-                } else {
-                    // +, - case
-                    token.lexeme[0] = c;
-                    token.lexeme[1] = '\0';
-                    token.type = TOKEN_OPERATOR;
-                    *pos += 1;
-                    last_token_type = 'o'; // operator
+        switch (scan_rules[rule].action) {
+            // Skip whitespace and comments
+            case SCAN_BLANK:
+                p = skip_blanks(p, input_end);
+                continue;
+
+            case SCAN_LINE_COMMENT:
+                // skip to the newline, the next blank run consumes it
+                p = find_newline(end, input_end);
+                continue;
+
+            case SCAN_BLOCK_COMMENT:
+                // skip until */ is reached
+                p = find_comment_end(end, input_end);
+                if (p == input_end) {
+                    if (lexer->options.warnings) {
+                        fprintf(lexer->options.warn_out, "[WARN]: Unclosed comment\n");
+                    }
+                    continue;
                 }
-                break;
+                p += 2; // move ahead of */
+                continue;
 
-            //Can be trailed only by an equals sign
-            case '*':
-            case '/':
-            case '%':
-            case '=':
-                if (c_next == '=') {
-                    // *=, /=, %=, ==
-                    token.lexeme[0] = c;
-                    token.lexeme[1] = c_next;
-                    token.lexeme[2] = '\0';
-                    token.type = TOKEN_OPERATOR;
-                    *pos += 2;
-                    last_token_type = 'q'; // equals
-                } else {
-                    // *, /, %, =
-                    token.lexeme[0] = c;
-                    token.lexeme[1] = '\0';
-                    token.type = TOKEN_OPERATOR;
-                    *pos += 1;
-                    last_token_type = 'o'; // operator
-                }
-                break;
+            case SCAN_NUMBER:
+                end = scan_number(p, end, &token);
+                *pos = (size_t)(end - input);
+                lexer->last_token_type = token.error != ERROR_NONE ? 'e' : scan_rules[rule].last_type;
+                return token;
 
-            //Can be chained together as many times as you want !!!!true
-            case '!':
-                if (c_next == '=') {
-                    //!= case
-                    token.lexeme[0] = c;
-                    token.lexeme[1] = c_next;
-                    token.lexeme[2] = '\0';
-                    token.type = TOKEN_OPERATOR;
-                    *pos += 2;
-                    last_token_type = 'q'; // equals
+            case SCAN_IDENTIFIER: {
+                // keywords are identifiers that the keyword hash recognizes
+                *pos = (size_t)(end - input);
+                if (keyword_lookup(p, (size_t)(end - p), hash)) {
+                    token.type = TOKEN_KEYWORD;
+                    lexer->last_token_type = 'k'; //keyword
                 } else {
-                    token.lexeme[0] = c;
-                    token.lexeme[1] = '\0';
-                    token.type = TOKEN_OPERATOR;
-                    *pos += 1;
-                    last_token_type = 'u'; // repeatable operator (unary)
+                    token.type = TOKEN_IDENTIFIER;
+                    lexer->last_token_type = scan_rules[rule].last_type;
+                    if (lexer->options.symbols != NULL) {
+                        token.symbol = symbols_intern(lexer->options.symbols, p, (size_t)(end - p), hash);
+                    }
                 }
-                break;
+                return token;
+            }
 
+            case SCAN_STRING:
+                scan_string(lexer, &token);
+                return token;
 
+            case SCAN_CHAR:
+                scan_char(lexer, &token);
+                return token;
 
-            //Can be trailed only by itself
-            case '|':
-            case '^':
-                if (c_next == c) {
-                    // ||, ^^
-                    token.lexeme[0] = c;
-                    token.lexeme[1] = c_next;
-                    token.lexeme[2] = '\0';
-                    token.type = TOKEN_OPERATOR;
-                    *pos += 2;
-                    last_token_type = 'o'; // operator
-                } else {
-                    // |, ^
-                    token.lexeme[0] = c;
-                    token.lexeme[1] = '\0';
-                    token.type = TOKEN_OPERATOR;
-                    *pos += 1;
-                    last_token_type = 'o'; // operator
+            case SCAN_OPERATOR:
+                // Check for consecutive operators
+                if (lexer->last_token_type == 'o' && !scan_follows_operator[(unsigned char)*p]) {
+                    token.error = ERROR_CONSECUTIVE_OPERATORS;
+                    (*pos)++;
+                    return token;
                 }
+                token.type = TOKEN_OPERATOR;
                 break;
 
-            //Can be trailed by itself or question mark and CANT standalone
-            case '&':
-                if (c_next == c || c_next == '?') {
-                    // &&, &?
-                    token.lexeme[0] = c;
-                    token.lexeme[1] = c_next;
-                    token.lexeme[2] = '\0';
-                    token.type = TOKEN_OPERATOR;
-                    *pos += 2;
-                    last_token_type = 'o'; // operator
-                }
+            case SCAN_DELIMITER:
+                token.type = TOKEN_DELIMITER;
                 break;
 
-            //RULE: Can repeat 3 times or be trailed by an equals sign
-            case '<':
-            case '>':
-                if (c_next == c) {
-                    // <<, <<<, >>, >>>
-                    //input of *pos+2 should be in bound because c_next was a regular character.
-                    if (input[*pos + 2] == c) {
-                        // <<<, >>>
-                        token.lexeme[0] = c;
-                        token.lexeme[1] = c;
-                        token.lexeme[2] = c;
-                        token.lexeme[3] = '\0';
-                        token.type = TOKEN_OPERATOR;
-                        *pos += 3;
-                        last_token_type = 'o'; // operator
-                    } else {
-                        // <<, >>
-                        token.lexeme[0] = c;
-                        token.lexeme[1] = c;
-                        token.lexeme[2] = '\0';
-                        token.type = TOKEN_OPERATOR;
-                        *pos += 2;
-                        last_token_type = 'o'; // operator
-                    }
-                    break;
-                }
-                //must be separate to prevent <=< from being valid, for example.
-                if (c_next == '=') {
-                    // <=, >=
-                    token.lexeme[0] = c;
-                    token.lexeme[1] = c_next;
-                    token.lexeme[2] = '\0';
-                    token.type = TOKEN_OPERATOR;
-                    *pos += 2;
-                    last_token_type = 'o'; // operator
-                } else {
-                    // <, >
-                    token.lexeme[0] = c;
-                    token.lexeme[1] = '\0';
-                    token.type = TOKEN_OPERATOR;
-                    *pos += 1;
-                    last_token_type = 'o'; // operator
-                }
+            case SCAN_SPECIAL:
+                token.type = TOKEN_SPECIAL_CHARACTER;
                 break;
-
-            case '$':
-                // $ is factorial
-                token.lexeme[0] = c;
-                token.lexeme[1] = '\0';
-                token.type = TOKEN_OPERATOR;
-                *pos += 1;
-                last_token_type = 'u'; //technically infinitely repeatable $$5 so unary
-
-            // If it somehow caught the operator but couldn't identify it, this catches it
-            default:
-                printf("[WARN]: Character %c was accepted by if statement but not assigned a case. Assuming standalone operator.\n", c);
         }
-        // "finally the token can return to the main function. May he finally rest..."
+        *pos = (size_t)(end - input);
+        lexer->last_token_type = scan_rules[rule].last_type;
         return token;
     }
+}
 
-    // Delimiter handler
-    // Bracket based Delimiters (must be closed)
-    if (c == '(' || c == '{' || c == '[' ||
-        c == ')' || c == '}' || c == ']') {
-        // should maybe write code to check for closure, but not yet
-        token.type = TOKEN_DELIMITER;
-        token.lexeme[0] = c;
-        token.lexeme[1] = '\0';
-        last_token_type = 'b'; //brackets (any type)
-        // note: could have last token type of r (regular), c {curvy}, s [square]
-        (*pos)++;
-        return token;
+void lexer_init(Lexer *lexer, const char *input, size_t length, const LexerOptions *options) {
+    lexer->input = input;
+    lexer->length = length;
+    lexer->pos = 0;
+    lexer->last_token_type = 'y';
+    lexer->options.warnings = 1;
+    lexer->options.warn_out = NULL;
+    lexer->options.symbols = NULL;
+    if (options != NULL) {
+        lexer->options = *options;
     }
-
-    // Generic Delimiters (don't need closure)
-    if (c == ';' || c == ',') {
-        token.type = TOKEN_DELIMITER;
-        token.lexeme[0] = c;
-        token.lexeme[1] = '\0';
-        last_token_type = 'd'; //delimiter
-        (*pos)++;
-        return token;
+    if (lexer->options.warn_out == NULL) {
+        lexer->options.warn_out = stdout;
     }
+}
 
-    // Handle invalid characters
-    token.error = ERROR_INVALID_CHAR;
-    token.lexeme[0] = c;
-    token.lexeme[1] = '\0';
-    last_token_type = 'e'; //error
-    (*pos)++;
+/* Get next token from input */
+Token get_next_token(Lexer *lexer) {
+    Token token = scan_token(lexer);
+    token.length = lexer->pos - token.start;
     return token;
 }
 
-int main() {
-    // get file
-    FILE *file = fopen("../phase1-w25/test/input_correct_lex.txt", "r");
-    if (file == NULL) {
-        printf("Error opening file\n");
-        return 1;
-    }
-
-    // get file size
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    rewind(file);
-
-    // get buffer size based on file size for chars
-    char *buffer = malloc(file_size + 1);
-    if (!buffer) {
-        printf("Memory allocation failed.\n");
-        fclose(file);
-        return 1;
-    }
-
-    // fill buffer with full file of chars in order
-    size_t bytes_read = fread(buffer, 1, file_size, file);
-    buffer[bytes_read] = '\0';
-    size_t b = 0;
-    for (size_t i = 0; i < bytes_read; i++) {
-        if (buffer[i] != '\r') {
-            buffer[b++] = buffer[i];
+size_t lexer_fill(Lexer *lexer, Token *tokens, size_t max) {
+    size_t count = 0;
+    while (count < max) {
+        Token token = scan_token(lexer);
+        token.length = lexer->pos - token.start;
+        tokens[count++] = token;
+        if (token.type == TOKEN_EOF) {
+            break;
         }
     }
-    buffer[b] = '\0';
-
-    // start at beginning of buffer
-    int position = 0;
-    Token token;
-
-    // perform tokenization
-    printf("Analyzing Correct Input:\n%s\n\n", buffer);
-    do {
-        token = get_next_token(buffer, &position);
-        print_token(token);
-    } while (token.type != TOKEN_EOF);
-
-    // free memory and close file
-    free(buffer);
-    fclose(file);
-
-    // Repeat for Incorrect file
-    current_line = 1;
+    return count;
+}
 
-    // get file
-    file = fopen("../phase1-w25/test/input_incorrect_lex.txt", "r");
-    if (file == NULL) {
-        printf("Error opening file\n");
-        return 1;
+int token_stream_reserve(TokenStream *stream, size_t capacity) {
+    if (capacity <= stream->capacity) {
+        return 0;
     }
-
-    // get file size
-    fseek(file, 0, SEEK_END);
-    file_size = ftell(file);
-    rewind(file);
-
-    // get buffer size based on file size for chars
-    buffer = malloc(file_size + 1);
-    if (!buffer) {
-        printf("Memory allocation failed.\n");
-        fclose(file);
-        return 1;
+    unsigned char *kinds = realloc(stream->kinds, capacity);
+    if (kinds) stream->kinds = kinds;
+    unsigned char *errors = realloc(stream->errors, capacity);
+    if (errors) stream->errors = errors;
+    unsigned char *flags = realloc(stream->flags, capacity);
+    if (flags) stream->flags = flags;
+    uint32_t *starts = realloc(stream->starts, capacity * sizeof(uint32_t));
+    if (starts) stream->starts = starts;
+    uint32_t *lengths = realloc(stream->lengths, capacity * sizeof(uint32_t));
+    if (lengths) stream->lengths = lengths;
+    uint32_t *symbols = realloc(stream->symbols, capacity * sizeof(uint32_t));
+    if (symbols) stream->symbols = symbols;
+    uint64_t *values = realloc(stream->values, capacity * sizeof(uint64_t));
+    if (values) stream->values = values;
+    if (!kinds || !errors || !flags || !starts || !lengths || !symbols || !values) {
+        return -1;
     }
+    stream->capacity = capacity;
+    return 0;
+}
 
-    // fill buffer with full file of chars in order
-    bytes_read = fread(buffer, 1, file_size, file);
-    buffer[bytes_read] = '\0';
-    b = 0;
-    for (size_t i = 0; i < bytes_read; i++) {
-        if (buffer[i] != '\r') {
-            buffer[b++] = buffer[i];
-        }
+int lex_all(const char *input, size_t length, const LexerOptions *options, TokenStream *out) {
+    memset(out, 0, sizeof(*out));
+    if (length > TOKEN_STREAM_MAX_INPUT) {
+        return -1;
+    }
+    // about one token per 4 bytes of source, grown by doubling when the guess is short
+    out->capacity = length / 4 + 64;
+    out->kinds = malloc(out->capacity);
+    out->errors = malloc(out->capacity);
+    out->flags = malloc(out->capacity);
+    out->starts = malloc(out->capacity * sizeof(uint32_t));
+    out->lengths = malloc(out->capacity * sizeof(uint32_t));
+    out->symbols = malloc(out->capacity * sizeof(uint32_t));
+    out->values = malloc(out->capacity * sizeof(uint64_t));
+    if (!out->kinds || !out->errors || !out->flags || !out->starts || !out->lengths || !out->symbols || !out->values) {
+        token_stream_free(out);
+        return -1;
     }
-    buffer[b] = '\0';
-
-    // start at beginning of buffer
-    position = 0;
 
-    // perform tokenization
-    printf("Analyzing Incorrect Input:\n%s\n\n", buffer);
+    Lexer lexer;
+    lexer_init(&lexer, input, length, options);
+    size_t count = 0;
+    Token token;
     do {
-        token = get_next_token(buffer, &position);
-        print_token(token);
+        if (count == out->capacity && token_stream_reserve(out, out->capacity * 2) != 0) {
+            token_stream_free(out);
+            return -1;
+        }
+        token = scan_token(&lexer);
+        out->kinds[count] = (unsigned char)token.type;
+        out->errors[count] = (unsigned char)token.error;
+        out->flags[count] = (unsigned char)token.flags;
+        out->starts[count] = (uint32_t)token.start;
+        out->lengths[count] = (uint32_t)(lexer.pos - token.start);
+        out->symbols[count] = token.symbol;
+        out->values[count] = token.value.integer;
+        count++;
     } while (token.type != TOKEN_EOF);
-
-    // free memory "he ain't deserve to be locked up"
-    free(buffer);
-    fclose(file);
+    out->count = count;
     return 0;
 }
+
+void token_stream_free(TokenStream *stream) {
+    free(stream->kinds);
+    free(stream->errors);
+    free(stream->flags);
+    free(stream->starts);
+    free(stream->lengths);
+    free(stream->symbols);
+    free(stream->values);
+    memset(stream, 0, sizeof(*stream));
+}
@@ -0,0 +1,290 @@
+/* lines.c
+ * Line start index: finds the line breaks 16 (SSE2) or 32 (AVX2) bytes at a time and
+ * answers line/column queries by binary search.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/lines.h"
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#define LINES_SIMD 1
+#include <immintrin.h>
+#endif
+
+#define LINES_MAX_OFFSET ((size_t)UINT32_MAX - 1)
+
+static int push_start(LineIndex *index, size_t start) {
+    if (index->count == index->capacity) {
+        size_t capacity = index->capacity != 0 ? index->capacity * 2 : 256;
+        uint32_t *starts = realloc(index->starts, capacity * sizeof(uint32_t));
+        if (!starts) {
+            return -1;
+        }
+        index->starts = starts;
+        index->capacity = capacity;
+    }
+    index->starts[index->count++] = (uint32_t)start;
+    return 0;
+}
+
+/* Add the line break at text[i] if it is one ('\n', or a '\r' not followed by '\n').
+ * A '\r' at limit - 1 is left out when more text follows */
+static inline int add_break(LineIndex *index, const char *text, size_t i, size_t limit,
+                            size_t at, int more) {
+    if (text[i] == '\r') {
+        if (i + 1 < limit ? text[i + 1] == '\n' : more) {
+            return 0;
+        }
+    }
+    return push_start(index, at + i + 1);
+}
+
+/* Every '\n' or '\r' in text[from, to), looking ahead up to limit for '\r\n' pairs */
+static int scan_range(LineIndex *index, const char *text, size_t from, size_t to, size_t limit,
+                      size_t at, int more) {
+    size_t i = from;
+#ifdef LINES_SIMD
+    // unaligned loads over whole blocks inside the range, so nothing past it is read
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage = _mm_set1_epi8('\r');
+    for (; i + 16 <= to; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(text + i));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, carriage));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hit);
+        while (mask != 0) {
+            if (add_break(index, text, i + (size_t)__builtin_ctz(mask), limit, at, more) != 0) {
+                return -1;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < to; i++) {
+        if ((text[i] == '\n' || text[i] == '\r') && add_break(index, text, i, limit, at, more) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+#ifdef LINES_SIMD
+__attribute__((target("avx2")))
+static int scan_range_avx2(LineIndex *index, const char *text, size_t from, size_t to, size_t limit,
+                           size_t at, int more) {
+    size_t i = from;
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriage = _mm256_set1_epi8('\r');
+    for (; i + 32 <= to; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(text + i));
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, newline), _mm256_cmpeq_epi8(v, carriage));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hit);
+        while (mask != 0) {
+            if (add_break(index, text, i + (size_t)__builtin_ctz(mask), limit, at, more) != 0) {
+                return -1;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return scan_range(index, text, i, to, limit, at, more);
+}
+
+static int use_avx2(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_cpu_supports("avx2");
+#else
+    return 0;
+#endif
+}
+#endif /* LINES_SIMD */
+
+static int scan_breaks(LineIndex *index, const char *text, size_t from, size_t to, size_t limit,
+                       size_t at, int more) {
+#ifdef LINES_SIMD
+    if (use_avx2()) {
+        return scan_range_avx2(index, text, from, to, limit, at, more);
+    }
+#endif
+    return scan_range(index, text, from, to, limit, at, more);
+}
+
+static int index_alloc(LineIndex *index, size_t capacity, size_t base, size_t first_line) {
+    memset(index, 0, sizeof(*index));
+    index->starts = malloc(capacity * sizeof(uint32_t));
+    if (!index->starts) {
+        return -1;
+    }
+    index->capacity = capacity;
+    index->starts[index->count++] = 0;
+    index->base = base;
+    index->first_line = first_line;
+    return 0;
+}
+
+int line_index_init(LineIndex *index, size_t base, size_t first_line) {
+    return index_alloc(index, 256, base, first_line);
+}
+
+int line_index_build(LineIndex *index, const char *input, size_t length) {
+    // lines of source run about 30 bytes, so this is usually the only allocation
+    if (length > LINES_MAX_OFFSET || index_alloc(index, length / 32 + 64, 0, 1) != 0) {
+        memset(index, 0, sizeof(*index));
+        return -1;
+    }
+    if (scan_breaks(index, input, 0, length, length, 0, 0) != 0) {
+        line_index_free(index);
+        return -1;
+    }
+    return 0;
+}
+
+int line_index_scan(LineIndex *index, const char *text, size_t length, size_t at, int more) {
+    if (at + length > LINES_MAX_OFFSET) {
+        return -1;
+    }
+    return scan_breaks(index, text, 0, length, length, at, more);
+}
+
+/* First line whose start is at least offset */
+static size_t first_start_from(const LineIndex *index, size_t offset) {
+    size_t low = 0, high = index->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (index->starts[mid] < offset) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+int line_index_edit(LineIndex *index, const char *input, size_t length,
+                    size_t offset, size_t deleted, size_t inserted) {
+    if (length > LINES_MAX_OFFSET) {
+        return -1;
+    }
+    // whether a byte is a line break depends on it and, for a '\r', the byte after it: the
+    // breaks that can change are at offset - 1 and in the edited bytes. Old line starts
+    // (break + 1) in [from + 1, offset + deleted] go; the new bytes are scanned for theirs
+    size_t from = offset > 0 ? offset - 1 : 0;
+    LineIndex fresh = {NULL, 0, 0, 0, 1};
+    if (scan_breaks(&fresh, input, from, offset + inserted, length, 0, 0) != 0) {
+        free(fresh.starts);
+        return -1;
+    }
+
+    size_t first = first_start_from(index, from + 1);
+    size_t end = first_start_from(index, offset + deleted + 1);
+    size_t count = index->count - (end - first) + fresh.count;
+    if (count > index->capacity) {
+        uint32_t *starts = realloc(index->starts, count * sizeof(uint32_t));
+        if (!starts) {
+            free(fresh.starts);
+            return -1;
+        }
+        index->starts = starts;
+        index->capacity = count;
+    }
+
+    memmove(index->starts + first + fresh.count, index->starts + end,
+            (index->count - end) * sizeof(uint32_t));
+    if (fresh.count > 0) {
+        memcpy(index->starts + first, fresh.starts, fresh.count * sizeof(uint32_t));
+    }
+    uint32_t shift = (uint32_t)inserted - (uint32_t)deleted;  // wraps around for a shrinking edit
+    for (size_t i = first + fresh.count; i < count; i++) {
+        index->starts[i] += shift;
+    }
+    index->count = count;
+    free(fresh.starts);
+    return 0;
+}
+
+LinePos line_index_locate(const LineIndex *index, size_t offset, size_t *hint) {
+    size_t target = offset > index->base ? offset - index->base : 0;
+    const uint32_t *starts = index->starts;
+    size_t low = 0, high = index->count;
+
+    // the hint line starts at or before target, so the search can start there; a sequential
+    // walk usually stays on the same line or moves to the next one
+    if (hint != NULL && *hint < high && starts[*hint] <= target) {
+        low = *hint;
+        if (low + 1 < high && starts[low + 1] <= target) {
+            low++;
+            if (low + 1 < high && starts[low + 1] <= target) {
+                low++;
+            } else {
+                high = low + 1;
+            }
+        } else {
+            high = low + 1;
+        }
+    }
+    // the last line that starts at or before target, starts[low] <= target throughout
+    while (high - low > 1) {
+        size_t mid = low + (high - low) / 2;
+        if (starts[mid] <= target) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    if (hint != NULL) {
+        *hint = low;
+    }
+    LinePos pos = {index->first_line + low, target - starts[low] + 1};
+    return pos;
+}
+
+void line_index_free(LineIndex *index) {
+    if (index->capacity != 0) {
+        free(index->starts);
+    }
+    memset(index, 0, sizeof(*index));
+}
+
+int line_cursor_init(LineCursor *cursor, const char *input, size_t length) {
+    cursor->input = input;
+    cursor->length = length;
+    cursor->end = 0;
+    cursor->hint = 0;
+    return line_index_init(&cursor->window, 0, 1);
+}
+
+/* Move the window to the last line start in it and scan the next LINE_CURSOR_WINDOW bytes */
+static int advance_window(LineCursor *cursor) {
+    LineIndex *window = &cursor->window;
+    size_t last = window->count - 1;
+    window->base += window->starts[last];
+    window->first_line += last;
+    window->starts[0] = 0;
+    window->count = 1;
+    cursor->hint = 0;
+
+    size_t to = cursor->length - cursor->end > LINE_CURSOR_WINDOW ? cursor->end + LINE_CURSOR_WINDOW
+                                                                   : cursor->length;
+    if (to - window->base > LINES_MAX_OFFSET) {
+        return -1;
+    }
+    // the whole text is there, so a '\r' at the end of the window looks at the byte after it
+    const char *text = cursor->input + window->base;
+    if (scan_breaks(window, text, cursor->end - window->base, to - window->base,
+                    cursor->length - window->base, 0, 0) != 0) {
+        return -1;
+    }
+    cursor->end = to;
+    return 0;
+}
+
+LinePos line_cursor_locate(LineCursor *cursor, size_t offset) {
+    while (offset >= cursor->end && cursor->end < cursor->length) {
+        if (advance_window(cursor) != 0) {
+            cursor->end = cursor->length;   // stop looking, the last window stays
+        }
+    }
+    return line_index_locate(&cursor->window, offset, &cursor->hint);
+}
+
+void line_cursor_free(LineCursor *cursor) {
+    line_index_free(&cursor->window);
+}
@@ -0,0 +1,272 @@
+/* number.c
+ * Numeric literal values: integers 8 digits at a time (SWAR), floats by the Eisel-Lemire
+ * algorithm, with strtod() for the rare literal whose digits it cannot settle.
+ */
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/number.h"
+#include "pow5_table.h"  // generated at build time by tools/gen_pow5.c
+
+#define MAX_DIGITS 19   // any 19 decimal digits fit in 64 bits
+
+static const uint64_t pow5_table[] = POW5_TABLE_INIT;
+
+/* Value of 8 digits: one load, then pairs, quads and the whole group are combined in place */
+static inline uint64_t parse_eight(const char *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    v -= 0x3030303030303030u;
+    v = v * 10 + (v >> 8);  // byte 2i holds digits 2i and 2i + 1 as a number below 100
+    return (((v & 0x000000FF000000FFu) * (100 + (1000000ull << 32))) +
+            (((v >> 16) & 0x000000FF000000FFu) * (1 + (10000ull << 32)))) >> 32;
+}
+
+/* Append up to max of digits[0, length) to *w, returns how many were used */
+static size_t append_digits(uint64_t *w, const char *digits, size_t length, size_t max) {
+    size_t limit = length < max ? length : max;
+    size_t i = 0;
+    for (; i + 8 <= limit; i += 8) {
+        *w = *w * 100000000u + parse_eight(digits + i);
+    }
+    for (; i < limit; i++) {
+        *w = *w * 10 + (uint64_t)(digits[i] - '0');
+    }
+    return i;
+}
+
+static size_t leading_zeros(const char *digits, size_t length) {
+    size_t i = 0;
+    while (i < length && digits[i] == '0') {
+        i++;
+    }
+    return i;
+}
+
+int parse_integer(const char *digits, size_t length, uint64_t *value) {
+    size_t zeros = leading_zeros(digits, length);
+    digits += zeros;
+    length -= zeros;
+
+    uint64_t w = 0;
+    size_t used = append_digits(&w, digits, length, MAX_DIGITS);
+    if (used < length) {
+        // a 20th digit fits only below UINT64_MAX = 18446744073709551615
+        uint64_t last = (uint64_t)(digits[used] - '0');
+        if (length > MAX_DIGITS + 1 || w > (UINT64_MAX - last) / 10) {
+            return -1;
+        }
+        w = w * 10 + last;
+    }
+    *value = w;
+    return 0;
+}
+
+/* Eisel-Lemire ----------------------------------------------------------------------------- */
+
+#define MANTISSA_BITS 52
+#define MIN_BINARY_EXPONENT (-1023)
+#define INFINITE_POWER 0x7FF
+
+typedef struct {
+    uint64_t high, low;
+} U128;
+
+static inline U128 multiply(uint64_t a, uint64_t b) {
+    U128 r;
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 product = (unsigned __int128)a * b;
+    r.high = (uint64_t)(product >> 64);
+    r.low = (uint64_t)product;
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32, b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+    r.high = hi_hi + (hi_lo >> 32) + (cross >> 32);
+    r.low = (cross << 32) | (uint32_t)lo_lo;
+#endif
+    return r;
+}
+
+/* Binary exponent and 53-bit mantissa (without its leading bit) of a double */
+typedef struct {
+    uint64_t mantissa;
+    int32_t power2;     // biased exponent, INFINITE_POWER for infinity
+} Binary;
+
+/* The double nearest w * 10^q for w != 0.
+ * w is normalized so its top bit is set and multiplied by the 128-bit truncated 5^q: the top
+ * 64 bits of the product hold the 55 bits a double and its rounding need, and a second
+ * multiplication by the low half of 5^q is only needed when the bits below them are all ones
+ * (they could carry). 2^q goes into the exponent. */
+static Binary compute_float(int64_t q, uint64_t w) {
+    Binary answer = {0, 0};
+    if (q < POW5_MIN_EXPONENT) {
+        return answer;
+    }
+    if (q > POW5_MAX_EXPONENT) {
+        answer.power2 = INFINITE_POWER;
+        return answer;
+    }
+    int lz = __builtin_clzll(w);
+    w <<= lz;
+
+    size_t index = 2 * (size_t)(q - POW5_MIN_EXPONENT);
+    U128 product = multiply(w, pow5_table[index]);
+    const uint64_t precision_mask = UINT64_MAX >> (MANTISSA_BITS + 3);
+    if ((product.high & precision_mask) == precision_mask) {
+        U128 second = multiply(w, pow5_table[index + 1]);
+        product.low += second.high;
+        if (second.high > product.low) {
+            product.high++;
+        }
+    }
+
+    int upper_bit = (int)(product.high >> 63);
+    int shift = upper_bit + 64 - MANTISSA_BITS - 3;
+    answer.mantissa = product.high >> shift;
+    // floor(q * log2(10)) + 63, exact over the table's range
+    int32_t power = (int32_t)(((152170 + 65536) * (int32_t)q) >> 16) + 63;
+    answer.power2 = power + upper_bit - lz - MIN_BINARY_EXPONENT;
+
+    if (answer.power2 <= 0) {
+        // subnormal: shift the mantissa down to the smallest exponent and round
+        if (-answer.power2 + 1 >= 64) {
+            answer.mantissa = 0;
+            answer.power2 = 0;
+            return answer;
+        }
+        answer.mantissa >>= -answer.power2 + 1;
+        answer.mantissa += answer.mantissa & 1;
+        answer.mantissa >>= 1;
+        answer.power2 = answer.mantissa < ((uint64_t)1 << MANTISSA_BITS) ? 0 : 1;
+        return answer;
+    }
+
+    // exactly halfway between two doubles: only possible for small q, round to even
+    if (product.low <= 1 && q >= -4 && q <= 23 && (answer.mantissa & 3) == 1 &&
+        (answer.mantissa << shift) == product.high) {
+        answer.mantissa &= ~(uint64_t)1;
+    }
+    answer.mantissa += answer.mantissa & 1;
+    answer.mantissa >>= 1;
+    if (answer.mantissa >= ((uint64_t)2 << MANTISSA_BITS)) {
+        answer.mantissa = (uint64_t)1 << MANTISSA_BITS;
+        answer.power2++;
+    }
+    answer.mantissa &= ~((uint64_t)1 << MANTISSA_BITS);
+    if (answer.power2 >= INFINITE_POWER) {
+        answer.power2 = INFINITE_POWER;
+        answer.mantissa = 0;
+    }
+    return answer;
+}
+
+static double to_double(Binary binary) {
+    uint64_t bits = binary.mantissa | ((uint64_t)binary.power2 << MANTISSA_BITS);
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+static int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/* Whether any of digits[0, length) is not '0' */
+static int any_nonzero(const char *digits, size_t length) {
+    return leading_zeros(digits, length) < length;
+}
+
+/* strtod() on a copy of the literal, for the odd case the 19 leading digits cannot decide */
+static double parse_slow(const char *text, size_t length) {
+    char small[128];
+    char *copy = length < sizeof(small) ? small : malloc(length + 1);
+    if (copy == NULL) {
+        return 0.0;
+    }
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    double d = strtod(copy, NULL);
+    if (copy != small) {
+        free(copy);
+    }
+    return d;
+}
+
+int parse_float(const char *text, size_t length, double *value) {
+    // the literal as w * 10^q, w holding at most MAX_DIGITS significant digits; truncated
+    // is set when a nonzero digit did not fit, the value is then just above w * 10^q
+    const char *p = text, *end = text + length;
+    const char *digits = p;
+    while (p < end && is_digit(*p)) {
+        p++;
+    }
+    size_t count = (size_t)(p - digits);
+    size_t zeros = leading_zeros(digits, count);
+    uint64_t w = 0;
+    size_t kept = append_digits(&w, digits + zeros, count - zeros, MAX_DIGITS);
+    int64_t q = (int64_t)(count - zeros - kept);
+    int truncated = any_nonzero(digits + zeros + kept, count - zeros - kept);
+
+    if (p < end && *p == '.') {
+        digits = ++p;
+        while (p < end && is_digit(*p)) {
+            p++;
+        }
+        count = (size_t)(p - digits);
+        zeros = kept == 0 ? leading_zeros(digits, count) : 0;
+        size_t used = append_digits(&w, digits + zeros, count - zeros, MAX_DIGITS - kept);
+        kept += used;
+        q -= (int64_t)(zeros + used);
+        truncated |= any_nonzero(digits + zeros + used, count - zeros - used);
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        int negative = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) {
+            p++;
+        }
+        int64_t exponent = 0;
+        for (; p < end && is_digit(*p); p++) {
+            if (exponent < 100000) {    // far past any double either way
+                exponent = exponent * 10 + (*p - '0');
+            }
+        }
+        q += negative ? -exponent : exponent;
+    }
+
+    if (w == 0) {
+        *value = 0.0;
+        return 0;
+    }
+#if FLT_EVAL_METHOD == 0
+    // w and 10^|q| are both exact doubles, so one correctly rounded operation gives the value
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+    if (!truncated && q >= -22 && q <= 22 && w <= ((uint64_t)1 << 53)) {
+        *value = q < 0 ? (double)w / powers_of_ten[-q] : (double)w * powers_of_ten[q];
+        return 0;
+    }
+#endif
+    Binary binary = compute_float(q, w);
+    if (truncated) {
+        // the value lies between w and w + 1 times 10^q, fine when both round the same way
+        Binary above = compute_float(q, w + 1);
+        if (above.mantissa != binary.mantissa || above.power2 != binary.power2) {
+            *value = parse_slow(text, length);
+            return *value > DBL_MAX ? -1 : 0;
+        }
+    }
+    if (binary.power2 == INFINITE_POWER) {
+        return -1;
+    }
+    *value = to_double(binary);
+    return 0;
+}
@@ -0,0 +1,452 @@
+/* parallel.c
+ * Intra-file parallel lexing: every range of the buffer is lexed speculatively on its own
+ * thread, then the speculative runs are stitched into exactly the sequential token stream.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../../include/lexer.h"
+#include "../../include/skip.h"
+#include "../../include/parallel.h"
+
+#define MIN_RANGE (64 * 1024)     // smaller ranges are not worth a thread
+#define BOUNDARY_SEARCH 4096      // how far a range boundary may move to reach a line start
+#define SPEC_WINDOW (16 * 1024)   // how far an alternate start state is followed before giving up
+
+/* Start states a range boundary can be in */
+enum { SPEC_NORMAL, SPEC_STRING, SPEC_COMMENT, SPEC_COUNT };
+
+/* Tokens from lexing one range under one assumption about the state at its start */
+typedef struct {
+    Token *tokens;              // in source order; past `owned` comes the sentinel, if any
+    unsigned char *after_op;    // after_op[k]: the token before tokens[k] left last_token_type 'o'
+    size_t count;
+    size_t owned;               // tokens before the sentinel
+    size_t capacity;
+    Lexer end;                  // lexer state right after the last stored token
+    int active;                 // the assumed start state was possible at all
+    int joined;                 // converged with the normal run at the normal run's join_index
+    size_t join_index;
+} SpecRun;
+
+typedef struct {
+    const char *input;
+    size_t length;
+    size_t start, end;          // byte range [start, end), the last range ends at length + 1
+    SpecRun runs[SPEC_COUNT];
+    SpecRun bridge;             // tokens lexed sequentially while stitching
+    int failed;
+} Range;
+
+/* A piece of the final token stream: run->tokens[from, to) */
+typedef struct {
+    const SpecRun *run;
+    size_t from, to;
+    size_t offset;              // where the piece goes in the output
+} Segment;
+
+/* The next token of the sequential token stream while stitching */
+typedef struct {
+    Token token;
+    int after_op;
+    Lexer after;                // lexer state right after it
+    int valid;                  // 0 once the EOF token has been placed
+} Pending;
+
+static const LexerOptions quiet = {0};
+
+static int run_push(SpecRun *run, const Token *token, int after_op) {
+    if (run->count == run->capacity) {
+        size_t capacity = run->capacity != 0 ? run->capacity * 2 : 1024;
+        Token *tokens = realloc(run->tokens, capacity * sizeof(Token));
+        if (!tokens) {
+            return -1;
+        }
+        run->tokens = tokens;
+        unsigned char *flags = realloc(run->after_op, capacity);
+        if (!flags) {
+            return -1;
+        }
+        run->after_op = flags;
+        run->capacity = capacity;
+    }
+    run->tokens[run->count] = *token;
+    run->after_op[run->count] = (unsigned char)after_op;
+    run->count++;
+    return 0;
+}
+
+static void run_free(SpecRun *run) {
+    free(run->tokens);
+    free(run->after_op);
+}
+
+/* Lex from pos, a token boundary under this run's assumption, up to and including the first
+ * token that starts at or after limit (the sentinel, where the stitched stream continues).
+ * An alternate run stops as soon as one of its tokens lines up with a token of the normal run
+ * in the same lexer state, because from there on both runs produce the same tokens.
+ */
+static int run_lex(SpecRun *run, const Range *range, size_t pos, char last, size_t limit,
+                   const SpecRun *normal) {
+    Lexer lexer;
+    lexer_init(&lexer, range->input, range->length, &quiet);
+    lexer.pos = pos;
+    lexer.last_token_type = last;
+    size_t cursor = 0;
+    run->active = 1;
+
+    for (;;) {
+        int after_op = lexer.last_token_type == 'o';
+        Token token = get_next_token(&lexer);
+
+        if (normal != NULL) {
+            while (cursor < normal->count && normal->tokens[cursor].start < token.start) {
+                cursor++;
+            }
+            if (cursor < normal->count && normal->tokens[cursor].start == token.start &&
+                normal->after_op[cursor] == after_op) {
+                run->joined = 1;
+                run->join_index = cursor;
+                run->owned = run->count;
+                return 0;
+            }
+        }
+
+        if (run_push(run, &token, after_op) != 0) {
+            return -1;
+        }
+        if (token.start >= limit) {
+            break;
+        }
+        if (token.type == TOKEN_EOF) {
+            run->owned = run->count;  // the EOF token belongs to the last range
+            run->end = lexer;
+            return 0;
+        }
+    }
+    run->owned = run->count - 1;
+    run->end = lexer;
+    return 0;
+}
+
+/* Offset just past the closing quote of a string literal that pos may be inside of,
+ * 0 when there is no closing quote inside the range */
+static size_t string_rest(const Range *range, size_t pos) {
+    const char *input = range->input;
+    const char *p = input + pos;
+    for (;;) {
+        p = find_string_stop(p, input + range->length);
+        if ((size_t)(p - input) >= range->end || (size_t)(p - input) == range->length) {
+            return 0;
+        }
+        if (*p == '"') {
+            return (size_t)(p - input) + 1;
+        }
+        p += (*p == '\\' && (size_t)(p - input) + 1 < range->length) ? 2 : 1;
+    }
+}
+
+/* Offset just past the closing star-slash of a comment that pos may be inside of,
+ * 0 when the comment does not close inside the range */
+static size_t comment_rest(const Range *range, size_t pos) {
+    const char *input = range->input;
+    size_t limit = range->end < range->length ? range->end : range->length;
+    while (pos < limit) {
+        const char *star = memchr(input + pos, '*', limit - pos);
+        if (star == NULL) {
+            break;
+        }
+        if (star[1] == '/') {
+            return (size_t)(star - input) + 2;
+        }
+        pos = (size_t)(star - input) + 1;
+    }
+    return 0;
+}
+
+static void *lex_range(void *arg) {
+    Range *range = arg;
+    SpecRun *normal = &range->runs[SPEC_NORMAL];
+
+    if (run_lex(normal, range, range->start, 'y', range->end, NULL) != 0) {
+        range->failed = 1;
+        return NULL;
+    }
+    if (range->start == 0) {
+        return NULL;  // the first range starts in a known state
+    }
+
+    // the boundary may be inside a string literal...
+    size_t pos = string_rest(range, range->start);
+    size_t limit = pos + SPEC_WINDOW < range->end ? pos + SPEC_WINDOW : range->end;
+    if (pos != 0 && run_lex(&range->runs[SPEC_STRING], range, pos, 's', limit, normal) != 0) {
+        range->failed = 1;
+        return NULL;
+    }
+    // ...or inside a /* */ comment
+    pos = comment_rest(range, range->start);
+    limit = pos + SPEC_WINDOW < range->end ? pos + SPEC_WINDOW : range->end;
+    if (pos != 0 && run_lex(&range->runs[SPEC_COMMENT], range, pos, 'y', limit, normal) != 0) {
+        range->failed = 1;
+    }
+    return NULL;
+}
+
+/* Index of the token of run that starts at start in the given lexer state, or -1 */
+static long find_token(const SpecRun *run, size_t start, int after_op) {
+    if (!run->active) {
+        return -1;
+    }
+    size_t low = 0, high = run->owned;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (run->tokens[mid].start < start) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < run->owned && run->tokens[low].start == start && run->after_op[low] == after_op) {
+        return (long)low;
+    }
+    return -1;
+}
+
+static int add_segment(Segment **segments, size_t *count, size_t *capacity,
+                       const SpecRun *run, size_t from, size_t to) {
+    if (from >= to) {
+        return 0;
+    }
+    // consecutive bridge tokens extend the previous piece
+    if (*count > 0) {
+        Segment *last = &(*segments)[*count - 1];
+        if (last->run == run && last->to == from) {
+            last->to = to;
+            return 0;
+        }
+    }
+    if (*count == *capacity) {
+        size_t grown = *capacity != 0 ? *capacity * 2 : 64;
+        Segment *resized = realloc(*segments, grown * sizeof(Segment));
+        if (!resized) {
+            return -1;
+        }
+        *segments = resized;
+        *capacity = grown;
+    }
+    Segment segment = {run, from, to, 0};
+    (*segments)[(*count)++] = segment;
+    return 0;
+}
+
+/* Continue the sequential stream after run's tokens: its sentinel is the next token */
+static void pending_from_run(Pending *pending, const SpecRun *run) {
+    if (run->count == run->owned) {
+        pending->valid = 0;  // the run ended with the EOF token
+        return;
+    }
+    pending->token = run->tokens[run->count - 1];
+    pending->after_op = run->after_op[run->count - 1];
+    pending->after = run->end;
+    pending->valid = 1;
+}
+
+typedef struct {
+    const Segment *segments;
+    size_t count;
+    size_t stride, first;       // this worker copies segments first, first + stride, ...
+    Token *out;
+} CopyJob;
+
+static void *copy_segments(void *arg) {
+    CopyJob *job = arg;
+    for (size_t i = job->first; i < job->count; i += job->stride) {
+        const Segment *segment = &job->segments[i];
+        memcpy(job->out + segment->offset, segment->run->tokens + segment->from,
+               (segment->to - segment->from) * sizeof(Token));
+    }
+    return NULL;
+}
+
+int lex_parallel(const char *input, size_t length, int threads, TokenList *out) {
+    out->tokens = NULL;
+    out->count = 0;
+
+    size_t count = threads > 0 ? (size_t)threads : 1;
+    if (count > length / MIN_RANGE) {
+        count = length / MIN_RANGE > 0 ? length / MIN_RANGE : 1;
+    }
+    Range *ranges = calloc(count, sizeof(Range));
+    pthread_t *workers = calloc(count, sizeof(pthread_t));
+    Segment *segments = NULL;
+    size_t segment_count = 0, segment_capacity = 0;
+    int result = -1;
+    if (!ranges || !workers) {
+        goto done;
+    }
+
+    // split at line starts, where the normal state is by far the most likely
+    size_t start = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t end = length * (i + 1) / count;
+        if (i + 1 == count) {
+            end = length + 1;  // the last range owns the EOF token
+        } else {
+            size_t window = length - end < BOUNDARY_SEARCH ? length - end : BOUNDARY_SEARCH;
+            const char *newline = memchr(input + end, '\n', window);
+            if (newline != NULL) {
+                end = (size_t)(newline - input) + 1;
+            }
+            if (end < start) {
+                end = start;
+            }
+        }
+        ranges[i].input = input;
+        ranges[i].length = length;
+        ranges[i].start = start;
+        ranges[i].end = end;
+        start = end;
+    }
+
+    // speculative lexing, range 0 on this thread
+    size_t started = 1;
+    for (; started < count; started++) {
+        if (pthread_create(&workers[started], NULL, lex_range, &ranges[started]) != 0) {
+            break;
+        }
+    }
+    for (size_t i = started; i < count; i++) {
+        lex_range(&ranges[i]);  // could not get a thread, lex it here
+    }
+    lex_range(&ranges[0]);
+    for (size_t i = 1; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (ranges[i].failed) {
+            goto done;
+        }
+    }
+
+    // stitch: range 0 is exact, every later range joins wherever one of its runs agrees with
+    // the sequential lexer, and tokens are lexed one at a time until that happens
+    SpecRun *first = &ranges[0].runs[SPEC_NORMAL];
+    Pending pending;
+    if (add_segment(&segments, &segment_count, &segment_capacity, first, 0, first->owned) != 0) {
+        goto done;
+    }
+    pending_from_run(&pending, first);
+
+    for (size_t i = 1; i < count && pending.valid; i++) {
+        Range *range = &ranges[i];
+        while (pending.valid && pending.token.start < range->end) {
+            int matched = 0;
+            for (int s = 0; s < SPEC_COUNT && !matched; s++) {
+                SpecRun *run = &range->runs[s];
+                long k = find_token(run, pending.token.start, pending.after_op);
+                if (k < 0) {
+                    continue;
+                }
+                if (add_segment(&segments, &segment_count, &segment_capacity, run, (size_t)k,
+                                run->owned) != 0) {
+                    goto done;
+                }
+                if (run->joined) {
+                    // the alternate run continues as the normal run
+                    SpecRun *normal = &range->runs[SPEC_NORMAL];
+                    if (add_segment(&segments, &segment_count, &segment_capacity, normal,
+                                    run->join_index, normal->owned) != 0) {
+                        goto done;
+                    }
+                    pending_from_run(&pending, normal);
+                } else {
+                    pending_from_run(&pending, run);
+                }
+                matched = 1;
+            }
+            if (matched) {
+                continue;
+            }
+
+            // no run agrees here: take this token as the sequential lexer sees it, try the next one
+            SpecRun *bridge = &range->bridge;
+            if (run_push(bridge, &pending.token, pending.after_op) != 0 ||
+                add_segment(&segments, &segment_count, &segment_capacity, bridge,
+                            bridge->count - 1, bridge->count) != 0) {
+                goto done;
+            }
+            if (pending.token.type == TOKEN_EOF) {
+                pending.valid = 0;
+                break;
+            }
+            Lexer lexer = pending.after;
+            pending.after_op = lexer.last_token_type == 'o';
+            pending.token = get_next_token(&lexer);
+            pending.after = lexer;
+        }
+    }
+
+    // copy the pieces into place in parallel, range 0's tokens are already where they belong
+    size_t total = 0;
+    for (size_t i = 0; i < segment_count; i++) {
+        segments[i].offset = total;
+        total += segments[i].to - segments[i].from;
+    }
+    size_t skip = segment_count > 0 && segments[0].run == first ? 1 : 0;
+    if (skip) {
+        out->tokens = realloc(first->tokens, total * sizeof(Token));
+        if (out->tokens != NULL) {
+            first->tokens = NULL;
+        }
+    } else {
+        out->tokens = malloc((total > 0 ? total : 1) * sizeof(Token));
+    }
+    if (!out->tokens) {
+        goto done;
+    }
+    out->count = total;
+
+    CopyJob jobs[64];
+    size_t copiers = count < 64 ? count : 64;
+    for (size_t t = 0; t < copiers; t++) {
+        CopyJob job = {segments, segment_count, copiers, skip + t, out->tokens};
+        jobs[t] = job;
+    }
+    started = 1;
+    for (; started < copiers; started++) {
+        if (pthread_create(&workers[started], NULL, copy_segments, &jobs[started]) != 0) {
+            break;
+        }
+    }
+    for (size_t t = started; t < copiers; t++) {
+        copy_segments(&jobs[t]);
+    }
+    copy_segments(&jobs[0]);
+    for (size_t t = 1; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    result = 0;
+
+done:
+    if (ranges) {
+        for (size_t i = 0; i < count; i++) {
+            for (int s = 0; s < SPEC_COUNT; s++) {
+                run_free(&ranges[i].runs[s]);
+            }
+            run_free(&ranges[i].bridge);
+        }
+    }
+    free(ranges);
+    free(workers);
+    free(segments);
+    if (result != 0) {
+        token_list_free(out);
+    }
+    return result;
+}
+
+void token_list_free(TokenList *list) {
+    free(list->tokens);
+    list->tokens = NULL;
+    list->count = 0;
+}
@@ -0,0 +1,209 @@
+/* seaplus_lexer.c
+ * The library's C API over lex_all(), the line index and the symbol table.
+ */
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/seaplus_lexer.h"
+#include "../../include/arena.h"
+#include "../../include/brackets.h"
+#include "../../include/lexer.h"
+#include "../../include/lines.h"
+#include "../../include/source.h"
+#include "../../include/symbols.h"
+#include "../../include/token_stream.h"
+
+#define COPY_PADDING 64     // zeroed slack after a copied buffer: its NUL terminator and lookahead
+
+// the public numbers are the internal ones; these break the build if the two drift apart
+_Static_assert((int)SEAPLUS_TOKEN_FLOAT == (int)TOKEN_FLOAT, "token types must match tokens.h");
+_Static_assert((int)SEAPLUS_TOKEN_SPECIAL_CHARACTER == (int)TOKEN_SPECIAL_CHARACTER, "token types must match tokens.h");
+_Static_assert((int)SEAPLUS_TOKEN_ERROR == (int)TOKEN_ERROR, "token types must match tokens.h");
+_Static_assert((int)SEAPLUS_ERROR_TOKEN_OVERFLOW == (int)ERROR_TOKEN_OVERFLOW, "errors must match tokens.h");
+_Static_assert((int)SEAPLUS_ERROR_OPEN_DELIMITER == (int)ERROR_OPEN_DELIMITER, "errors must match tokens.h");
+_Static_assert((int)SEAPLUS_ERROR_UNMATCHED_DELIMITER == (int)ERROR_UNMATCHED_DELIMITER, "errors must match tokens.h");
+_Static_assert(SEAPLUS_FLAG_ESCAPES == TOKEN_FLAG_ESCAPES, "flags must match tokens.h");
+
+struct SeaplusLexer {
+    const char *input;      // the buffer lexed last: copy or file.data
+    size_t length;
+    char *copy;             // seaplus_lexer_lex()'s copy of the caller's buffer
+    size_t copy_capacity;
+    SourceFile file;        // seaplus_lexer_lex_file()'s file, while file_open
+    int file_open;
+    TokenStream tokens;
+    BracketIndex brackets;
+    LineIndex lines;
+    size_t line_hint;       // line of the last token looked up
+    size_t next;            // token seaplus_lexer_next() returns
+    SymbolTable symbols;    // kept from one buffer to the next
+    Arena literals;         // decoded literals of the current buffer
+};
+
+int seaplus_lexer_version(void) {
+    return SEAPLUS_LEXER_API_VERSION;
+}
+
+SeaplusLexer *seaplus_lexer_create(void) {
+    SeaplusLexer *lexer = calloc(1, sizeof(SeaplusLexer));
+    if (lexer == NULL) {
+        return NULL;
+    }
+    if (symbols_init(&lexer->symbols) != 0) {
+        free(lexer);
+        return NULL;
+    }
+    arena_init(&lexer->literals);
+    return lexer;
+}
+
+/* Drop the current buffer and everything that refers to it */
+static void release_buffer(SeaplusLexer *lexer) {
+    token_stream_free(&lexer->tokens);
+    bracket_index_free(&lexer->brackets);
+    line_index_free(&lexer->lines);
+    arena_free(&lexer->literals);
+    if (lexer->file_open) {
+        source_close(&lexer->file);
+        lexer->file_open = 0;
+    }
+    lexer->input = NULL;
+    lexer->length = 0;
+    lexer->next = 0;
+    lexer->line_hint = 0;
+}
+
+/* Lex lexer->input into the token stream, pair its brackets and index its lines */
+static int lex_input(SeaplusLexer *lexer) {
+    LexerOptions options = {0, NULL, &lexer->symbols};
+    if (lex_all(lexer->input, lexer->length, &options, &lexer->tokens) != 0) {
+        return -1;
+    }
+    if (bracket_index_build(&lexer->brackets, &lexer->tokens, lexer->input) != 0 ||
+        line_index_build(&lexer->lines, lexer->input, lexer->length) != 0) {
+        token_stream_free(&lexer->tokens);
+        bracket_index_free(&lexer->brackets);
+        return -1;
+    }
+    return 0;
+}
+
+int seaplus_lexer_lex(SeaplusLexer *lexer, const char *data, size_t length) {
+    release_buffer(lexer);
+    if (length > TOKEN_STREAM_MAX_INPUT) {
+        return -1;
+    }
+    if (lexer->copy_capacity < length + COPY_PADDING) {
+        char *copy = realloc(lexer->copy, length + COPY_PADDING);
+        if (copy == NULL) {
+            return -1;
+        }
+        lexer->copy = copy;
+        lexer->copy_capacity = length + COPY_PADDING;
+    }
+    memcpy(lexer->copy, data, length);
+    memset(lexer->copy + length, 0, COPY_PADDING);
+    lexer->input = lexer->copy;
+    lexer->length = length;
+    return lex_input(lexer);
+}
+
+int seaplus_lexer_lex_file(SeaplusLexer *lexer, const char *path) {
+    release_buffer(lexer);
+    if (source_open(&lexer->file, path) != 0) {
+        return -1;
+    }
+    lexer->file_open = 1;
+    lexer->input = lexer->file.data;
+    lexer->length = lexer->file.length;
+    if (lex_input(lexer) != 0) {
+        release_buffer(lexer);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+size_t seaplus_lexer_count(const SeaplusLexer *lexer) {
+    return lexer->tokens.count;
+}
+
+int seaplus_lexer_get(SeaplusLexer *lexer, size_t index, SeaplusToken *token) {
+    if (index >= lexer->tokens.count) {
+        return -1;
+    }
+    const TokenStream *tokens = &lexer->tokens;
+    LinePos pos = line_index_locate(&lexer->lines, tokens->starts[index], &lexer->line_hint);
+    token->type = tokens->kinds[index];
+    token->error = tokens->errors[index];
+    token->start = tokens->starts[index];
+    token->length = tokens->lengths[index];
+    token->line = (uint32_t)pos.line;
+    token->column = (uint32_t)pos.column;
+    token->symbol = tokens->symbols[index];
+    token->flags = tokens->flags[index];
+    token->value.integer = tokens->values[index];
+    token->text = lexer->input + tokens->starts[index];
+    if (token->type == SEAPLUS_TOKEN_DELIMITER && token->error == SEAPLUS_ERROR_NONE &&
+        bracket_partner(&lexer->brackets, index) == BRACKET_NONE) {
+        if (bracket_opens(*token->text)) {
+            token->error = SEAPLUS_ERROR_OPEN_DELIMITER;
+        } else if (bracket_closes(*token->text)) {
+            token->error = SEAPLUS_ERROR_UNMATCHED_DELIMITER;
+        }
+    }
+    return 0;
+}
+
+int seaplus_lexer_next(SeaplusLexer *lexer, SeaplusToken *token) {
+    if (seaplus_lexer_get(lexer, lexer->next, token) != 0) {
+        return 0;
+    }
+    lexer->next++;
+    return 1;
+}
+
+size_t seaplus_lexer_partner(const SeaplusLexer *lexer, size_t index) {
+    if (index >= lexer->brackets.count || bracket_partner(&lexer->brackets, index) == BRACKET_NONE) {
+        return SEAPLUS_NO_PARTNER;
+    }
+    return bracket_partner(&lexer->brackets, index);
+}
+
+const char *seaplus_lexer_literal(SeaplusLexer *lexer, const SeaplusToken *token, size_t *length) {
+    if ((token->type != SEAPLUS_TOKEN_STRING_LITERAL && token->type != SEAPLUS_TOKEN_CHAR_LITERAL) ||
+        token->error != SEAPLUS_ERROR_NONE || lexer->input == NULL) {
+        return NULL;
+    }
+    Token local = {(TokenType)token->type, ERROR_NONE, (size_t)token->start, (size_t)token->length,
+                   token->symbol, token->flags, {token->value.integer}};
+    return token_literal(&lexer->literals, lexer->input, &local, length);
+}
+
+const char *seaplus_lexer_symbol_name(const SeaplusLexer *lexer, uint32_t symbol, size_t *length) {
+    if (symbol == SYMBOL_NONE || symbol > lexer->symbols.count) {
+        return NULL;
+    }
+    if (length != NULL) {
+        *length = symbol_length(&lexer->symbols, symbol);
+    }
+    return symbol_name(&lexer->symbols, symbol);
+}
+
+const char *seaplus_token_type_name(uint32_t type) {
+    return token_type_name((TokenType)type);
+}
+
+const char *seaplus_error_message(uint32_t error) {
+    return error_message((ErrorType)error);
+}
+
+void seaplus_lexer_destroy(SeaplusLexer *lexer) {
+    if (lexer == NULL) {
+        return;
+    }
+    release_buffer(lexer);
+    symbols_free(&lexer->symbols);
+    free(lexer->copy);
+    free(lexer);
+}
@@ -0,0 +1,302 @@
+/* skip.c
+ * Whitespace, comment, string literal and binary skipping, 16 (SSE2) or 32 (AVX2) bytes at a time.
+ * The AVX2 path is picked at run time; targets without SSE2 use the scalar loops.
+ * The vector loops only load whole blocks inside [p, end) and leave the last few bytes to the
+ * scalar loops, so nothing outside the caller's buffer is ever read.
+ */
+#include <stdint.h>
+#include "../../include/skip.h"
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#define SKIP_SIMD 1
+#include <immintrin.h>
+#endif
+
+#define IS_BLANK(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+#define IS_TEXT(c) (((unsigned char)(c) >= 0x20 && (unsigned char)(c) < 0x7F) || \
+                    (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+/* Scalar loops: the whole scan on targets without SSE2, the tail of it on the others */
+static inline const char *skip_blanks_scalar(const char *p, const char *end) {
+    while (p < end && IS_BLANK(*p)) {
+        p++;
+    }
+    return p;
+}
+
+static inline const char *find_newline_scalar(const char *p, const char *end) {
+    while (p < end && *p != '\n' && *p != '\r') {
+        p++;
+    }
+    return p;
+}
+
+static inline const char *find_comment_end_scalar(const char *p, const char *end) {
+    while (p < end && !(p[0] == '*' && p + 1 < end && p[1] == '/')) {
+        p++;
+    }
+    return p;
+}
+
+static inline const char *find_string_stop_scalar(const char *p, const char *end) {
+    while (p < end && *p != '"' && *p != '\\' && *p != '\r') {
+        p++;
+    }
+    return p;
+}
+
+static inline const char *skip_binary_scalar(const char *p, const char *end) {
+    while (p < end && !IS_TEXT(*p)) {
+        p++;
+    }
+    return p;
+}
+
+#ifdef SKIP_SIMD
+
+static const char *skip_blanks_sse2(const char *p, const char *end) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage = _mm_set1_epi8('\r');
+
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i breaks = _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, carriage));
+        __m128i blank = _mm_or_si128(breaks, _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)));
+        unsigned int other = ~(unsigned int)_mm_movemask_epi8(blank) & 0xFFFFu;
+        if (other != 0) {
+            return p + __builtin_ctz(other);
+        }
+    }
+    return skip_blanks_scalar(p, end);
+}
+
+static const char *find_newline_sse2(const char *p, const char *end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage = _mm_set1_epi8('\r');
+
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i breaks = _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, carriage));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(breaks);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return find_newline_scalar(p, end);
+}
+
+static const char *find_string_stop_sse2(const char *p, const char *end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i carriage = _mm_set1_epi8('\r');
+
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i decode = _mm_or_si128(_mm_cmpeq_epi8(v, backslash), _mm_cmpeq_epi8(v, carriage));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote), decode));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return find_string_stop_scalar(p, end);
+}
+
+static const char *find_comment_end_sse2(const char *p, const char *end) {
+    const __m128i star = _mm_set1_epi8('*');
+    const __m128i slash = _mm_set1_epi8('/');
+
+    // one byte past the block is read too, for a "*/" that straddles two blocks
+    for (; end - p > 16; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        unsigned int stars = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, star));
+        unsigned int slashes = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, slash));
+        slashes |= (unsigned int)(p[16] == '/') << 16;
+        // bit i set when byte i is '*' and byte i + 1 is '/'
+        unsigned int stop_mask = stars & (slashes >> 1);
+        if (stop_mask != 0) {
+            return p + __builtin_ctz(stop_mask);
+        }
+    }
+    return find_comment_end_scalar(p, end);
+}
+
+static const char *skip_binary_sse2(const char *p, const char *end) {
+    const __m128i below_printable = _mm_set1_epi8(0x1F);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage = _mm_set1_epi8('\r');
+
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        // signed compare: bytes from 0x80 up are negative and fail it along with the controls
+        __m128i printable = _mm_andnot_si128(_mm_cmpeq_epi8(v, del), _mm_cmpgt_epi8(v, below_printable));
+        __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, carriage)));
+        __m128i text = _mm_or_si128(printable, blank);
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(text);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return skip_binary_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char *skip_blanks_avx2(const char *p, const char *end) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriage = _mm256_set1_epi8('\r');
+
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i breaks = _mm256_or_si256(_mm256_cmpeq_epi8(v, newline), _mm256_cmpeq_epi8(v, carriage));
+        __m256i blank = _mm256_or_si256(breaks, _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)));
+        unsigned int other = ~(unsigned int)_mm256_movemask_epi8(blank);
+        if (other != 0) {
+            return p + __builtin_ctz(other);
+        }
+    }
+    return skip_blanks_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char *find_newline_avx2(const char *p, const char *end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriage = _mm256_set1_epi8('\r');
+
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i breaks = _mm256_or_si256(_mm256_cmpeq_epi8(v, newline), _mm256_cmpeq_epi8(v, carriage));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(breaks);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return find_newline_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char *find_string_stop_avx2(const char *p, const char *end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i carriage = _mm256_set1_epi8('\r');
+
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i decode = _mm256_or_si256(_mm256_cmpeq_epi8(v, backslash), _mm256_cmpeq_epi8(v, carriage));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), decode));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return find_string_stop_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char *find_comment_end_avx2(const char *p, const char *end) {
+    const __m256i star = _mm256_set1_epi8('*');
+    const __m256i slash = _mm256_set1_epi8('/');
+
+    for (; end - p > 32; p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        uint64_t stars = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, star));
+        uint64_t slashes = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, slash));
+        slashes |= (uint64_t)(p[32] == '/') << 32;
+        uint64_t stop_mask = stars & (slashes >> 1);
+        if (stop_mask != 0) {
+            return p + __builtin_ctzll(stop_mask);
+        }
+    }
+    return find_comment_end_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char *skip_binary_avx2(const char *p, const char *end) {
+    const __m256i below_printable = _mm256_set1_epi8(0x1F);
+    const __m256i del = _mm256_set1_epi8(0x7F);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriage = _mm256_set1_epi8('\r');
+
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i printable = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, del), _mm256_cmpgt_epi8(v, below_printable));
+        __m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(v, tab), _mm256_or_si256(_mm256_cmpeq_epi8(v, newline), _mm256_cmpeq_epi8(v, carriage)));
+        __m256i text = _mm256_or_si256(printable, blank);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(text);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return skip_binary_sse2(p, end);
+}
+
+static int use_avx2(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_cpu_supports("avx2");
+#else
+    return 0;
+#endif
+}
+
+const char *skip_blanks(const char *p, const char *end) {
+    // most gaps between tokens are empty or a single space, don't pay for a vector load there
+    if (p == end || !IS_BLANK(p[0])) {
+        return p;
+    }
+    if (p[0] == ' ' && (p + 1 == end || !IS_BLANK(p[1]))) {
+        return p + 1;
+    }
+    return use_avx2() ? skip_blanks_avx2(p, end) : skip_blanks_sse2(p, end);
+}
+
+const char *find_newline(const char *p, const char *end) {
+    return use_avx2() ? find_newline_avx2(p, end) : find_newline_sse2(p, end);
+}
+
+const char *find_comment_end(const char *p, const char *end) {
+    return use_avx2() ? find_comment_end_avx2(p, end) : find_comment_end_sse2(p, end);
+}
+
+const char *find_string_stop(const char *p, const char *end) {
+    return use_avx2() ? find_string_stop_avx2(p, end) : find_string_stop_sse2(p, end);
+}
+
+const char *skip_binary(const char *p, const char *end) {
+    // a stray byte in otherwise readable source is followed by text, only binary runs need the vector loop
+    if (p == end || IS_TEXT(p[0])) {
+        return p;
+    }
+    if (p + 1 == end || IS_TEXT(p[1])) {
+        return p + 1;
+    }
+    return use_avx2() ? skip_binary_avx2(p, end) : skip_binary_sse2(p, end);
+}
+
+#else /* !SKIP_SIMD */
+
+const char *skip_blanks(const char *p, const char *end) {
+    return skip_blanks_scalar(p, end);
+}
+
+const char *find_newline(const char *p, const char *end) {
+    return find_newline_scalar(p, end);
+}
+
+const char *find_comment_end(const char *p, const char *end) {
+    return find_comment_end_scalar(p, end);
+}
+
+const char *find_string_stop(const char *p, const char *end) {
+    return find_string_stop_scalar(p, end);
+}
+
+const char *skip_binary(const char *p, const char *end) {
+    return skip_binary_scalar(p, end);
+}
+
+#endif /* SKIP_SIMD */
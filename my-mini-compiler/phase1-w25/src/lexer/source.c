@@ -0,0 +1,130 @@
+/* source.c
+ * Input loading for the lexer: mmap for regular files, a heap buffer for everything else.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/source.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define SOURCE_MMAP 1
+#endif
+
+/* Read everything from file into a heap buffer, growing it as needed */
+static int read_stream(SourceFile *src, FILE *file) {
+    size_t capacity = 64 * 1024;
+    size_t length = 0;
+    char *data = malloc(capacity);
+    if (!data) {
+        return -1;
+    }
+
+    for (;;) {
+        // keep room for the terminator
+        if (capacity - length < 2) {
+            char *grown = realloc(data, capacity * 2);
+            if (!grown) {
+                free(data);
+                return -1;
+            }
+            data = grown;
+            capacity *= 2;
+        }
+        size_t n = fread(data + length, 1, capacity - length - 1, file);
+        length += n;
+        if (n == 0) {
+            break;
+        }
+    }
+    if (ferror(file)) {
+        free(data);
+        return -1;
+    }
+
+    data[length] = '\0';
+    src->data = data;
+    src->length = length;
+    src->map_length = 0;
+    return 0;
+}
+
+#ifdef SOURCE_MMAP
+/* Map a regular file in place.
+ * An anonymous zero-filled region one byte longer than the file is reserved first and the
+ * file is mapped over its start, so there is always a '\0' right after the last byte even
+ * when the file size is an exact multiple of the page size.
+ * The mapping is read-only: the lexer never writes to its input.
+ */
+static int map_file(SourceFile *src, int fd, size_t length) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t map_length = (length + 1 + page - 1) / page * page;
+
+    char *base = mmap(NULL, map_length, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+    if (length > 0 &&
+        mmap(base, length, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, map_length);
+        return -1;
+    }
+    // the lexer walks the file front to back exactly once
+    madvise(base, map_length, MADV_SEQUENTIAL);
+
+    src->data = base;
+    src->length = length;
+    src->map_length = map_length;
+    return 0;
+}
+#endif
+
+int source_open(SourceFile *src, const char *path) {
+    memset(src, 0, sizeof(*src));
+
+    if (strcmp(path, "-") == 0) {
+        return read_stream(src, stdin);
+    }
+
+#ifdef SOURCE_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && map_file(src, fd, (size_t)info.st_size) == 0) {
+        close(fd);
+        return 0;
+    }
+    // not a regular file (FIFO, character device, ...) or mmap failed: fall back to reading it
+    FILE *file = fdopen(fd, "rb");
+    if (file == NULL) {
+        close(fd);
+        return -1;
+    }
+#else
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+#endif
+
+    int result = read_stream(src, file);
+    fclose(file);
+    return result;
+}
+
+void source_close(SourceFile *src) {
+#ifdef SOURCE_MMAP
+    if (src->map_length != 0) {
+        munmap((void *)src->data, src->map_length);
+        src->data = NULL;
+        return;
+    }
+#endif
+    free((void *)src->data);
+    src->data = NULL;
+}
@@ -0,0 +1,170 @@
+/* stats.c
+ * Lexer statistics: merging, the summary and the Prometheus text file.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/lexer.h"
+#include "../../include/stats.h"
+
+// label values for the error counters
+static const char *const error_names[STATS_ERROR_TYPES] = {
+    [ERROR_NONE] = "NONE",
+    [ERROR_INVALID_CHAR] = "INVALID_CHAR",
+    [ERROR_INVALID_NUMBER] = "INVALID_NUMBER",
+    [ERROR_CONSECUTIVE_OPERATORS] = "CONSECUTIVE_OPERATORS",
+    [ERROR_STRING_OVERFLOW] = "STRING_OVERFLOW",
+    [ERROR_UNTERMINATED_STRING] = "UNTERMINATED_STRING",
+    [ERROR_INVALID_ESCAPE_CHARACTER] = "INVALID_ESCAPE_CHARACTER",
+    [ERROR_UNTERMINATED_CHARACTER] = "UNTERMINATED_CHARACTER",
+    [ERROR_OPEN_DELIMITER] = "OPEN_DELIMITER",
+    [ERROR_TOKEN_OVERFLOW] = "TOKEN_OVERFLOW",
+    [ERROR_UNMATCHED_DELIMITER] = "UNMATCHED_DELIMITER",
+};
+
+void stats_init(LexStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    for (int t = 0; t < STATS_TOKEN_TYPES; t++) {
+        stats->shortest[t] = UINT64_MAX;
+    }
+}
+
+void stats_merge(LexStats *into, const LexStats *from) {
+    for (int t = 0; t < STATS_TOKEN_TYPES; t++) {
+        into->tokens[t] += from->tokens[t];
+        into->lexeme_bytes[t] += from->lexeme_bytes[t];
+        if (from->shortest[t] < into->shortest[t]) {
+            into->shortest[t] = from->shortest[t];
+        }
+        if (from->longest[t] > into->longest[t]) {
+            into->longest[t] = from->longest[t];
+        }
+    }
+    for (int e = 0; e < STATS_ERROR_TYPES; e++) {
+        into->errors[e] += from->errors[e];
+    }
+    into->files += from->files;
+    into->bytes += from->bytes;
+}
+
+static uint64_t total_tokens(const LexStats *stats) {
+    uint64_t total = 0;
+    for (int t = 0; t < STATS_TOKEN_TYPES; t++) {
+        total += stats->tokens[t];
+    }
+    return total;
+}
+
+// input bytes outside every token: whitespace and comments
+static uint64_t skipped_bytes(const LexStats *stats) {
+    uint64_t covered = 0;
+    for (int t = 0; t < STATS_TOKEN_TYPES; t++) {
+        covered += stats->lexeme_bytes[t];
+    }
+    return covered < stats->bytes ? stats->bytes - covered : 0;
+}
+
+void stats_print(FILE *out, const LexStats *stats) {
+    uint64_t tokens = total_tokens(stats);
+    double seconds = stats->seconds > 0 ? stats->seconds : 1e-9;
+    fprintf(out, "Lexer statistics\n");
+    fprintf(out, "  files: %llu, input: %llu bytes, skipped (whitespace and comments): %llu bytes\n",
+            (unsigned long long)stats->files, (unsigned long long)stats->bytes,
+            (unsigned long long)skipped_bytes(stats));
+    fprintf(out, "  wall time: %.6f s, %.1f MB/s, %.0f tokens/s\n", stats->seconds,
+            (double)stats->bytes / (1024.0 * 1024.0) / seconds, (double)tokens / seconds);
+    fprintf(out, "  %-20s %12s %8s %10s %8s\n", "token type", "count", "min len", "mean len", "max len");
+    for (int t = 0; t < STATS_TOKEN_TYPES; t++) {
+        if (stats->tokens[t] == 0) {
+            continue;
+        }
+        fprintf(out, "  %-20s %12llu %8llu %10.2f %8llu\n", token_type_name((TokenType)t),
+                (unsigned long long)stats->tokens[t], (unsigned long long)stats->shortest[t],
+                (double)stats->lexeme_bytes[t] / (double)stats->tokens[t],
+                (unsigned long long)stats->longest[t]);
+    }
+    fprintf(out, "  %-20s %12llu\n", "total", (unsigned long long)tokens);
+    for (int e = ERROR_NONE + 1; e < STATS_ERROR_TYPES; e++) {
+        if (stats->errors[e] != 0) {
+            fprintf(out, "  error %-38s %12llu\n", error_message((ErrorType)e),
+                    (unsigned long long)stats->errors[e]);
+        }
+    }
+}
+
+int stats_write_prometheus(const char *path, const LexStats *stats) {
+    size_t length = strlen(path);
+    char *temporary = malloc(length + 5);
+    if (temporary == NULL) {
+        return -1;
+    }
+    memcpy(temporary, path, length);
+    memcpy(temporary + length, ".tmp", 5);
+    FILE *out = fopen(temporary, "w");
+    if (out == NULL) {
+        free(temporary);
+        return -1;
+    }
+
+    fprintf(out, "# HELP seaplus_lexer_tokens_total Tokens lexed, by token type.\n");
+    fprintf(out, "# TYPE seaplus_lexer_tokens_total counter\n");
+    for (int t = 0; t < STATS_TOKEN_TYPES; t++) {
+        fprintf(out, "seaplus_lexer_tokens_total{type=\"%s\"} %llu\n", token_type_name((TokenType)t),
+                (unsigned long long)stats->tokens[t]);
+    }
+    fprintf(out, "# HELP seaplus_lexer_errors_total Lexical errors, by error type.\n");
+    fprintf(out, "# TYPE seaplus_lexer_errors_total counter\n");
+    for (int e = ERROR_NONE + 1; e < STATS_ERROR_TYPES; e++) {
+        fprintf(out, "seaplus_lexer_errors_total{error=\"%s\"} %llu\n", error_names[e],
+                (unsigned long long)stats->errors[e]);
+    }
+    fprintf(out, "# HELP seaplus_lexer_lexeme_bytes_total Bytes in lexemes, by token type.\n");
+    fprintf(out, "# TYPE seaplus_lexer_lexeme_bytes_total counter\n");
+    for (int t = 0; t < STATS_TOKEN_TYPES; t++) {
+        fprintf(out, "seaplus_lexer_lexeme_bytes_total{type=\"%s\"} %llu\n", token_type_name((TokenType)t),
+                (unsigned long long)stats->lexeme_bytes[t]);
+    }
+    fprintf(out, "# HELP seaplus_lexer_lexeme_length_min Shortest lexeme, by token type.\n");
+    fprintf(out, "# TYPE seaplus_lexer_lexeme_length_min gauge\n");
+    for (int t = 0; t < STATS_TOKEN_TYPES; t++) {
+        if (stats->tokens[t] != 0) {
+            fprintf(out, "seaplus_lexer_lexeme_length_min{type=\"%s\"} %llu\n",
+                    token_type_name((TokenType)t), (unsigned long long)stats->shortest[t]);
+        }
+    }
+    fprintf(out, "# HELP seaplus_lexer_lexeme_length_max Longest lexeme, by token type.\n");
+    fprintf(out, "# TYPE seaplus_lexer_lexeme_length_max gauge\n");
+    for (int t = 0; t < STATS_TOKEN_TYPES; t++) {
+        if (stats->tokens[t] != 0) {
+            fprintf(out, "seaplus_lexer_lexeme_length_max{type=\"%s\"} %llu\n",
+                    token_type_name((TokenType)t), (unsigned long long)stats->longest[t]);
+        }
+    }
+    fprintf(out, "# HELP seaplus_lexer_files_total Inputs lexed.\n");
+    fprintf(out, "# TYPE seaplus_lexer_files_total counter\n");
+    fprintf(out, "seaplus_lexer_files_total %llu\n", (unsigned long long)stats->files);
+    fprintf(out, "# HELP seaplus_lexer_input_bytes_total Input bytes lexed.\n");
+    fprintf(out, "# TYPE seaplus_lexer_input_bytes_total counter\n");
+    fprintf(out, "seaplus_lexer_input_bytes_total %llu\n", (unsigned long long)stats->bytes);
+    fprintf(out, "# HELP seaplus_lexer_skipped_bytes_total Input bytes in whitespace and comments.\n");
+    fprintf(out, "# TYPE seaplus_lexer_skipped_bytes_total counter\n");
+    fprintf(out, "seaplus_lexer_skipped_bytes_total %llu\n", (unsigned long long)skipped_bytes(stats));
+    fprintf(out, "# HELP seaplus_lexer_wall_seconds Wall time of the run.\n");
+    fprintf(out, "# TYPE seaplus_lexer_wall_seconds gauge\n");
+    fprintf(out, "seaplus_lexer_wall_seconds %.9f\n", stats->seconds);
+    fprintf(out, "# HELP seaplus_lexer_throughput_bytes_per_second Input bytes per second of wall time.\n");
+    fprintf(out, "# TYPE seaplus_lexer_throughput_bytes_per_second gauge\n");
+    fprintf(out, "seaplus_lexer_throughput_bytes_per_second %.1f\n",
+            stats->seconds > 0 ? (double)stats->bytes / stats->seconds : 0.0);
+
+    int failed = ferror(out);
+    failed |= fclose(out) != 0;
+    if (!failed && rename(temporary, path) != 0) {
+        failed = 1;
+    }
+    if (failed) {
+        remove(temporary);
+    }
+    free(temporary);
+    return failed ? -1 : 0;
+}
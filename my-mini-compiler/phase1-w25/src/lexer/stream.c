@@ -0,0 +1,277 @@
+/* stream.c
+ * Streaming lexer: runs a Lexer over a fixed-size window that is refilled from a FILE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include "../../include/lexer.h"
+#include "../../include/skip.h"
+#include "../../include/stream.h"
+
+#define STREAM_LOOKAHEAD 4  // bytes the scanner may look at past the end of a token
+#define STREAM_PADDING 64   // zeroed slack after the window: its NUL terminator and lookahead
+
+int stream_open(LexStream *stream, FILE *file, size_t window, const LexerOptions *options) {
+    memset(stream, 0, sizeof(*stream));
+    if (window == 0) {
+        window = STREAM_DEFAULT_WINDOW;
+    }
+    if (window < STREAM_MIN_WINDOW) {
+        window = STREAM_MIN_WINDOW;
+    }
+    stream->buffer = calloc(window + STREAM_PADDING, 1);
+    if (!stream->buffer || line_index_init(&stream->lines, 0, 1) != 0) {
+        free(stream->buffer);
+        return -1;
+    }
+    stream->file = file;
+    stream->capacity = window;
+
+    lexer_init(&stream->lexer, stream->buffer, 0, options);
+    // a token near the end of the window may be scanned again, so intern only final ones
+    stream->symbols = stream->lexer.options.symbols;
+    stream->lexer.options.symbols = NULL;
+    return 0;
+}
+
+void stream_close(LexStream *stream) {
+    free(stream->buffer);
+    stream->buffer = NULL;
+    line_index_free(&stream->lines);
+}
+
+/* Index the lines of the window after a refill that moved its start forward by keep bytes.
+ * The line holding the new start is found in the old index; a '\r' that ended the old
+ * window and was dropped with it is a line break unless the new window starts with '\n' */
+static void stream_index_lines(LexStream *stream, LinePos first, int dropped_cr) {
+    LineIndex *lines = &stream->lines;
+    size_t line_start = stream->base - (first.column - 1);
+    if (dropped_cr && stream->buffer[0] != '\n') {
+        first.line++;
+        line_start = stream->base;
+    }
+    lines->count = 1;
+    lines->starts[0] = 0;
+    lines->base = line_start;
+    lines->first_line = first.line;
+    // out of memory only loses the lines past the ones found so far
+    line_index_scan(lines, stream->buffer, stream->fill, stream->base - line_start, !stream->eof);
+    stream->split_cr = !stream->eof && stream->fill > 0 && stream->buffer[stream->fill - 1] == '\r';
+}
+
+/* Drop everything in the window before keep and top it up from the file */
+static void stream_refill(LexStream *stream, size_t keep) {
+    LinePos first = line_index_locate(&stream->lines, stream->base + keep, NULL);
+    int dropped_cr = stream->split_cr && keep == stream->fill;
+    size_t kept = stream->fill - keep;
+    memmove(stream->buffer, stream->buffer + keep, kept);
+    stream->base += keep;
+    stream->lexer.pos -= keep;
+    stream->fill = kept;
+
+    while (!stream->eof && stream->fill < stream->capacity) {
+        size_t n = fread(stream->buffer + stream->fill, 1, stream->capacity - stream->fill, stream->file);
+        if (n == 0) {
+            stream->eof = 1;
+        }
+        stream->fill += n;
+    }
+    memset(stream->buffer + stream->fill, 0, STREAM_PADDING);
+    stream->lexer.length = stream->fill;
+    stream_index_lines(stream, first, dropped_cr);
+}
+
+/* Skip whitespace and comments in the window.
+ * Until the end of input the last byte of the window is held back: it may be the second half
+ * of a \r\n pair or of a comment delimiter, and the kernels must see it together with the
+ * byte before it. A \r just before it is held back too, since a \r is only a line break of
+ * its own when the next byte is not \n. Returns 1 when the cursor is at a token start (or
+ * the end of input), 0 when the window ran out first.
+ */
+static int stream_skip_trivia(LexStream *stream) {
+    if (!stream->eof && stream->fill < 2) {
+        return 0;
+    }
+    char *buffer = stream->buffer;
+    size_t limit = stream->fill;
+    if (!stream->eof) {
+        limit--;
+        if (buffer[limit - 1] == '\r') {
+            limit--;
+        }
+        if (limit < stream->lexer.pos) {
+            return 0;
+        }
+    }
+    char held = buffer[limit];
+    buffer[limit] = '\0';
+    const char *end = buffer + limit;
+    const char *p = buffer + stream->lexer.pos;
+    int ready = 1;
+
+    for (;;) {
+        // finish a comment that the previous window ended in
+        if (stream->comment == '*') {
+            const char *from = p;
+            p = find_comment_end(p, end);
+            if (p == end) {
+                if (!stream->eof) {
+                    // a '*' right before the held byte may be the start of the closing */
+                    if (p > from && p[-1] == '*') {
+                        p--;
+                    }
+                } else {
+                    if (stream->lexer.options.warnings) {
+                        fprintf(stream->lexer.options.warn_out, "[WARN]: Unclosed comment\n");
+                    }
+                    stream->comment = 0;
+                }
+                break;
+            }
+            p += 2; // move ahead of */
+            stream->comment = 0;
+            continue;
+        }
+        if (stream->comment == '#') {
+            p = find_newline(p, end);
+            if (p == end) {
+                if (stream->eof) {
+                    stream->comment = 0;
+                }
+                break;
+            }
+            stream->comment = 0;
+            continue;
+        }
+
+        p = skip_blanks(p, end);
+        if (*p == '#') {
+            p++;
+            stream->comment = '#';
+            continue;
+        }
+        if (*p == '/' && p[1] == '*') {
+            p += 2;
+            stream->comment = '*';
+            continue;
+        }
+        // a '/' right before the held byte may still open a comment
+        if (*p == '/' && p + 1 == end && !stream->eof) {
+            ready = 0;
+        }
+        break;
+    }
+    if ((p == end && !stream->eof) || stream->comment != 0) {
+        ready = 0;
+    }
+
+    buffer[limit] = held;
+    stream->lexer.pos = (size_t)(p - buffer);
+    return ready;
+}
+
+/* The token at the start of a full window does not fit in it.
+ * Consume the rest of it without keeping its text and report it as an overflow. */
+static Token stream_oversized_token(LexStream *stream) {
+    Token token = {TOKEN_ERROR, ERROR_TOKEN_OVERFLOW, stream->base, 0, SYMBOL_NONE, 0, {0}};
+    stream->oversized = line_index_locate(&stream->lines, stream->base, NULL);
+    char first = stream->buffer[0];
+    int in_string = first == '"';
+    // the only other tokens that can outgrow the window are runs of invalid characters
+    int junk = !in_string && first != '\'' && !isalnum((unsigned char)first) && first != '_';
+    int escaped = 0;
+    size_t i = 1;
+
+    if (in_string) {
+        token.error = ERROR_STRING_OVERFLOW;
+    } else if (junk) {
+        token.error = ERROR_INVALID_CHAR;
+    }
+    for (;;) {
+        if (i >= stream->fill) {
+            if (stream->eof) {
+                if (in_string) {
+                    token.error = ERROR_UNTERMINATED_STRING;
+                }
+                break;
+            }
+            stream->lexer.pos = i;
+            stream_refill(stream, i);
+            i = 0;
+            continue;
+        }
+
+        char c = stream->buffer[i];
+        if (in_string) {
+            i++;
+            if (escaped) {
+                escaped = 0;
+            } else if (c == '\\') {
+                escaped = 1;
+            } else if (c == '"') {
+                break;
+            }
+        } else if (junk) {
+            if (token_can_start(c)) {
+                break;
+            }
+            i++;
+        } else if (isdigit(first) ? isdigit(c) : (isalnum(c) || c == '_')) {
+            i++;
+        } else {
+            break;
+        }
+    }
+
+    stream->lexer.pos = i;
+    token.length = stream->base + i - token.start;
+    stream->lexer.last_token_type = 'e'; //error
+    return token;
+}
+
+Token stream_next_token(LexStream *stream) {
+    // find the start of the next token, pulling in more input as needed
+    while (!stream_skip_trivia(stream)) {
+        stream_refill(stream, stream->lexer.pos);
+    }
+
+    for (;;) {
+        size_t start = stream->lexer.pos;
+        char last = stream->lexer.last_token_type;
+        Token token = get_next_token(&stream->lexer);
+
+        // the token is final once the scanner provably did not look past the window
+        if (stream->eof || stream->lexer.pos + STREAM_LOOKAHEAD < stream->fill) {
+            if (token.type == TOKEN_IDENTIFIER && stream->symbols != NULL) {
+                const char *name = stream->buffer + token.start;
+                token.symbol = symbols_intern(stream->symbols, name, token.length,
+                                              symbol_hash(name, token.length));
+            }
+            token.start += stream->base;
+            return token;
+        }
+
+        // it may continue in the next chunk: undo it and scan it again with more input
+        stream->lexer.pos = start;
+        stream->lexer.last_token_type = last;
+        if (start == 0 && stream->fill == stream->capacity) {
+            return stream_oversized_token(stream);
+        }
+        stream_refill(stream, start);
+    }
+}
+
+const char *stream_lexeme(const LexStream *stream, const Token *token) {
+    if (token->start < stream->base || token->start - stream->base + token->length > stream->fill) {
+        return NULL;  // oversized token, its text is gone
+    }
+    return stream->buffer + (token->start - stream->base);
+}
+
+LinePos stream_position(const LexStream *stream, const Token *token) {
+    if (token->start < stream->lines.base) {
+        return stream->oversized;  // its line has left the window
+    }
+    return line_index_locate(&stream->lines, token->start, NULL);
+}
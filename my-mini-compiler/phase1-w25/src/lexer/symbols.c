@@ -0,0 +1,160 @@
+/* symbols.c
+ * Identifier interning for the lexer.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/keywords.h"
+#include "../../include/symbols.h"
+
+#define INITIAL_SLOTS 1024
+#define INITIAL_NAMES (16 * 1024)
+
+/* Slot to start probing at. The keyword hash is a plain polynomial, so mix it before
+ * taking the low bits */
+static inline size_t home_slot(unsigned int hash, size_t mask) {
+    uint32_t h = (uint32_t)hash * 0x9E3779B1u;
+    return (size_t)(h ^ (h >> 16)) & mask;
+}
+
+int symbols_init(SymbolTable *table) {
+    memset(table, 0, sizeof(*table));
+    table->mask = INITIAL_SLOTS - 1;
+    table->capacity = INITIAL_SLOTS / 2 + 1;
+    table->names_capacity = INITIAL_NAMES;
+    table->slots = calloc(INITIAL_SLOTS, sizeof(SymbolSlot));
+    table->names = malloc(table->names_capacity);
+    table->starts = malloc(table->capacity * sizeof(uint32_t));
+    table->lengths = malloc(table->capacity * sizeof(uint32_t));
+    if (!table->slots || !table->names || !table->starts || !table->lengths) {
+        symbols_free(table);
+        return -1;
+    }
+    return 0;
+}
+
+unsigned int symbol_hash(const char *name, size_t length) {
+    unsigned int hash = KEYWORD_HASH_INIT;
+    for (size_t i = 0; i < length; i++) {
+        hash = KEYWORD_HASH_STEP(hash, name[i]);
+    }
+    return hash;
+}
+
+static inline int same_name(const SymbolTable *table, uint32_t symbol, const char *name, size_t length) {
+    return table->lengths[symbol] == length &&
+           memcmp(table->names + table->starts[symbol], name, length) == 0;
+}
+
+uint32_t symbols_find(const SymbolTable *table, const char *name, size_t length, unsigned int hash) {
+    for (size_t i = home_slot(hash, table->mask);; i = (i + 1) & table->mask) {
+        const SymbolSlot *slot = &table->slots[i];
+        if (slot->symbol == SYMBOL_NONE) {
+            return SYMBOL_NONE;
+        }
+        if (slot->hash == hash && same_name(table, slot->symbol, name, length)) {
+            return slot->symbol;
+        }
+    }
+}
+
+/* Double the slot array and re-insert every symbol; the hashes are kept in the slots */
+static int grow_slots(SymbolTable *table) {
+    size_t mask = table->mask * 2 + 1;
+    SymbolSlot *slots = calloc(mask + 1, sizeof(SymbolSlot));
+    if (!slots) {
+        return -1;
+    }
+    for (size_t i = 0; i <= table->mask; i++) {
+        SymbolSlot slot = table->slots[i];
+        if (slot.symbol != SYMBOL_NONE) {
+            size_t j = home_slot(slot.hash, mask);
+            while (slots[j].symbol != SYMBOL_NONE) {
+                j = (j + 1) & mask;
+            }
+            slots[j] = slot;
+        }
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->mask = mask;
+    return 0;
+}
+
+/* Make room for one more symbol with a name of length characters */
+static int reserve(SymbolTable *table, size_t length) {
+    if ((size_t)table->count + 1 > (table->mask + 1) / 2 && grow_slots(table) != 0) {
+        return -1;
+    }
+    if (table->count + 1 >= table->capacity) {
+        if (table->capacity >= UINT32_MAX / 2) {
+            return -1;
+        }
+        uint32_t capacity = table->capacity * 2;
+        uint32_t *starts = realloc(table->starts, capacity * sizeof(uint32_t));
+        if (starts) table->starts = starts;
+        uint32_t *lengths = realloc(table->lengths, capacity * sizeof(uint32_t));
+        if (lengths) table->lengths = lengths;
+        if (!starts || !lengths) {
+            return -1;
+        }
+        table->capacity = capacity;
+    }
+    if (table->names_capacity - table->names_size < length + 1) {
+        size_t capacity = table->names_capacity * 2;
+        while (capacity - table->names_size < length + 1) {
+            capacity *= 2;
+        }
+        if (capacity > UINT32_MAX) {
+            return -1;  // starts are 32-bit
+        }
+        char *names = realloc(table->names, capacity);
+        if (!names) {
+            return -1;
+        }
+        table->names = names;
+        table->names_capacity = capacity;
+    }
+    return 0;
+}
+
+uint32_t symbols_intern(SymbolTable *table, const char *name, size_t length, unsigned int hash) {
+    size_t i = home_slot(hash, table->mask);
+    for (;; i = (i + 1) & table->mask) {
+        const SymbolSlot *slot = &table->slots[i];
+        if (slot->symbol == SYMBOL_NONE) {
+            break;
+        }
+        if (slot->hash == hash && same_name(table, slot->symbol, name, length)) {
+            return slot->symbol;
+        }
+    }
+
+    // new symbol: the free slot found above is only still right if the slots did not grow
+    size_t mask = table->mask;
+    if (reserve(table, length) != 0) {
+        return SYMBOL_NONE;
+    }
+    if (table->mask != mask) {
+        for (i = home_slot(hash, table->mask); table->slots[i].symbol != SYMBOL_NONE;
+             i = (i + 1) & table->mask) {
+        }
+    }
+
+    uint32_t symbol = ++table->count;
+    table->starts[symbol] = (uint32_t)table->names_size;
+    table->lengths[symbol] = (uint32_t)length;
+    memcpy(table->names + table->names_size, name, length);
+    table->names[table->names_size + length] = '\0';
+    table->names_size += length + 1;
+    table->slots[i].hash = hash;
+    table->slots[i].symbol = symbol;
+    return symbol;
+}
+
+void symbols_free(SymbolTable *table) {
+    free(table->slots);
+    free(table->names);
+    free(table->starts);
+    free(table->lengths);
+    memset(table, 0, sizeof(*table));
+}
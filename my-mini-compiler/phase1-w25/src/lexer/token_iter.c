@@ -0,0 +1,49 @@
+/* token_iter.c
+ * Token iterator with lookahead over a ring of pre-lexed tokens.
+ */
+#include <stdlib.h>
+#include "../../include/token_iter.h"
+
+int token_iter_init(TokenIter *iter, const char *input, size_t length, size_t lookahead,
+                    const LexerOptions *options) {
+    if (lookahead == 0) {
+        lookahead = 1;
+    }
+    size_t slots = TOKEN_ITER_BATCH;
+    while (slots < lookahead) {
+        slots *= 2;
+    }
+    lexer_init(&iter->lexer, input, length, options);
+    iter->ring = malloc(slots * sizeof(Token));
+    iter->mask = slots - 1;
+    iter->head = 0;
+    iter->tail = 0;
+    iter->lookahead = lookahead;
+    iter->done = 0;
+    Token eof = {TOKEN_EOF, ERROR_NONE, length, 0, SYMBOL_NONE, 0, {0}};
+    iter->eof = eof;
+    return iter->ring != NULL ? 0 : -1;
+}
+
+void token_iter_fill(TokenIter *iter) {
+    size_t slots = iter->mask + 1;
+    while (!iter->done && iter->tail - iter->head < slots) {
+        // the free slots run from tail to the end of the ring, then on from its start
+        size_t at = iter->tail & iter->mask;
+        size_t room = slots - (iter->tail - iter->head);
+        if (room > slots - at) {
+            room = slots - at;
+        }
+        size_t count = lexer_fill(&iter->lexer, iter->ring + at, room);
+        iter->tail += count;
+        if (iter->ring[(iter->tail - 1) & iter->mask].type == TOKEN_EOF) {
+            iter->eof = iter->ring[(iter->tail - 1) & iter->mask];
+            iter->done = 1;
+        }
+    }
+}
+
+void token_iter_free(TokenIter *iter) {
+    free(iter->ring);
+    iter->ring = NULL;
+}
@@ -0,0 +1,140 @@
+/* tokfile.c
+ * Writer and mmap reader for binary token files (.tok).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/tokfile.h"
+
+#define RECORD_CHUNK 4096
+
+static uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+/* Write n zero bytes, to pad a section out to the next one */
+static int write_padding(FILE *out, uint64_t n) {
+    static const char zeros[8] = {0};
+    return n == 0 || fwrite(zeros, 1, (size_t)n, out) == (size_t)n ? 0 : -1;
+}
+
+int tokfile_write(FILE *out, const char *source, size_t length, const TokenStream *tokens,
+                  const SymbolTable *symbols) {
+    if (length > TOKEN_STREAM_MAX_INPUT) {
+        return -1;
+    }
+    LineIndex lines;
+    if (line_index_build(&lines, source, length) != 0) {
+        return -1;
+    }
+    uint32_t line_count = (uint32_t)lines.count;
+
+    TokHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TOKFILE_MAGIC, 4);
+    header.version = TOKFILE_VERSION;
+    header.record_size = sizeof(TokRecord);
+    header.byte_order = TOKFILE_BYTE_ORDER;
+    header.symbol_count = symbols != NULL ? symbols->count : 0;
+    header.line_count = line_count;
+    header.token_count = tokens->count;
+    header.source_length = length;
+    header.records_offset = align8(sizeof(TokHeader));
+    header.symbols_offset = align8(header.records_offset + tokens->count * sizeof(TokRecord));
+    header.names_offset = header.symbols_offset + ((uint64_t)header.symbol_count + 1) * sizeof(uint32_t);
+    header.names_size = symbols != NULL ? symbols->names_size : 0;
+    header.lines_offset = align8(header.names_offset + header.names_size);
+    header.source_offset = align8(header.lines_offset + (uint64_t)line_count * sizeof(uint32_t));
+
+    int failed = fwrite(&header, sizeof(header), 1, out) != 1;
+    failed |= write_padding(out, header.records_offset - sizeof(header));
+
+    TokRecord chunk[RECORD_CHUNK];
+    for (size_t i = 0; i < tokens->count && !failed; i += RECORD_CHUNK) {
+        size_t n = tokens->count - i < RECORD_CHUNK ? tokens->count - i : RECORD_CHUNK;
+        for (size_t k = 0; k < n; k++) {
+            TokRecord *r = &chunk[k];
+            r->type = tokens->kinds[i + k];
+            r->error = tokens->errors[i + k];
+            r->flags = tokens->flags[i + k];
+            r->reserved = 0;
+            r->start = tokens->starts[i + k];
+            r->length = tokens->lengths[i + k];
+            r->symbol = tokens->symbols[i + k];
+            r->value = tokens->values[i + k];
+        }
+        failed |= fwrite(chunk, sizeof(TokRecord), n, out) != n;
+    }
+    uint64_t end = header.records_offset + tokens->count * sizeof(TokRecord);
+    failed |= write_padding(out, header.symbols_offset - end);
+
+    // symbol table: the intern table's offsets and names are already in the file's layout
+    uint32_t unused = 0;
+    failed |= fwrite(&unused, sizeof(uint32_t), 1, out) != 1;
+    if (header.symbol_count > 0) {
+        failed |= fwrite(symbols->starts + 1, sizeof(uint32_t), header.symbol_count, out) != header.symbol_count;
+        failed |= fwrite(symbols->names, 1, symbols->names_size, out) != symbols->names_size;
+    }
+    failed |= write_padding(out, header.lines_offset - (header.names_offset + header.names_size));
+
+    failed |= fwrite(lines.starts, sizeof(uint32_t), line_count, out) != line_count;
+    failed |= write_padding(out, header.source_offset - (header.lines_offset + (uint64_t)line_count * sizeof(uint32_t)));
+    failed |= fwrite(source, 1, length, out) != length;
+    failed |= fputc('\0', out) == EOF;
+
+    line_index_free(&lines);
+    return failed ? -1 : 0;
+}
+
+/* Does a section of count elements of size bytes at offset fit in a file of length bytes?
+ * Nothing here can overflow, whatever the header holds */
+static int section_fits(uint64_t offset, uint64_t count, uint64_t size, uint64_t length) {
+    return offset % 4 == 0 && offset <= length && count <= (length - offset) / size;
+}
+
+int tokfile_open(TokFile *tok, const char *path) {
+    memset(tok, 0, sizeof(*tok));
+    if (source_open(&tok->file, path) != 0) {
+        return -1;
+    }
+    const char *data = tok->file.data;
+    uint64_t length = tok->file.length;
+    const TokHeader *header = (const TokHeader *)data;
+    if (length < sizeof(TokHeader) || memcmp(header->magic, TOKFILE_MAGIC, 4) != 0 ||
+        header->version != TOKFILE_VERSION || header->record_size != sizeof(TokRecord) ||
+        header->byte_order != TOKFILE_BYTE_ORDER ||
+        header->records_offset % 8 != 0 ||
+        !section_fits(header->records_offset, header->token_count, sizeof(TokRecord), length) ||
+        !section_fits(header->symbols_offset, (uint64_t)header->symbol_count + 1, sizeof(uint32_t), length) ||
+        !section_fits(header->names_offset, header->names_size, 1, length) ||
+        header->line_count == 0 ||
+        !section_fits(header->lines_offset, header->line_count, sizeof(uint32_t), length) ||
+        // the source and its terminator: source_length + 1 could wrap
+        !section_fits(header->source_offset, header->source_length, 1, length) ||
+        header->source_length == length - header->source_offset ||
+        data[header->source_offset + header->source_length] != '\0' ||
+        (header->names_size > 0 && data[header->names_offset + header->names_size - 1] != '\0') ||
+        *(const uint32_t *)(data + header->lines_offset) != 0) {
+        tokfile_close(tok);
+        return -1;
+    }
+
+    tok->header = header;
+    tok->records = (const TokRecord *)(data + header->records_offset);
+    tok->count = (size_t)header->token_count;
+    tok->symbol_starts = (const uint32_t *)(data + header->symbols_offset);
+    tok->names = data + header->names_offset;
+    tok->symbol_count = header->symbol_count;
+    tok->line_starts = (const uint32_t *)(data + header->lines_offset);
+    tok->line_count = header->line_count;
+    tok->source = data + header->source_offset;
+    tok->source_length = (size_t)header->source_length;
+    return 0;
+}
+
+void tokfile_close(TokFile *tok) {
+    if (tok->file.data != NULL) {
+        source_close(&tok->file);
+    }
+    memset(tok, 0, sizeof(*tok));
+}
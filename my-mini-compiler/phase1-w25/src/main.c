@@ -0,0 +1,379 @@
+/* main.c
+ * Command line driver for the lexer.
+ */
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/tokens.h"
+#include "../include/batch.h"
+#include "../include/emit.h"
+#include "../include/lexer.h"
+#include "../include/parallel.h"
+#include "../include/source.h"
+#include "../include/stats.h"
+#include "../include/stream.h"
+#include "../include/tokfile.h"
+#include "../include/token_stream.h"
+
+/* [WARN] notes go to stdout between the tokens for text output, to stderr otherwise
+ * (and when the tokens go to a file) */
+static FILE *notes_output(const Emitter *out) {
+    return out->format == EMIT_TEXT && out->fd == STDOUT_FILENO ? stdout : stderr;
+}
+
+static void print_usage(const char *program) {
+    printf("usage: %s [options] [--batch] [--threads N] [--list FILE] PATH...\n"
+           "       %s [options] --parallel THREADS FILE\n"
+           "       %s [options] --stream [--window BYTES] [FILE]\n"
+           "       %s --tok OUTPUT FILE\n"
+           "       %s [options] --read-tok FILE\n"
+           "PATH is a file, a directory tree or - for stdin; without one the test inputs are lexed.\n"
+           "options:\n"
+           "  --format text|json|csv  output format (text)\n"
+           "  -o, --output FILE       write the tokens to FILE instead of stdout\n"
+           "  --no-echo               leave the source text out of file headers\n"
+           "  --max-errors N          list lexical errors after each file's tokens, the first N (0: all)\n"
+           "  --stats                 throughput and token counts on stderr\n"
+           "  --stats-file FILE       the same in Prometheus text format\n",
+           program, program, program, program, program);
+}
+
+/* Lex a file (or stdin) through the bounded streaming window and emit its tokens */
+static int analyze_stream(const char *path, size_t window, Emitter *out, LexStats *stats) {
+    FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (file == NULL) {
+        printf("Error opening file\n");
+        return 1;
+    }
+
+    LexStream stream;
+    LexerOptions options = {1, notes_output(out), NULL};
+    if (stream_open(&stream, file, window, &options) != 0) {
+        printf("Memory allocation failed.\n");
+        if (file != stdin) {
+            fclose(file);
+        }
+        return 1;
+    }
+
+    out->title = path;
+    Token token;
+    do {
+        token = stream_next_token(&stream);
+        if (token.type == TOKEN_EOF) {
+            // an unclosed comment note was just printed, put it after the tokens before it
+            emitter_flush(out);
+            fflush(stdout);
+        }
+        emit_token_at(out, stream_lexeme(&stream, &token), &token, stream_position(&stream, &token));
+        if (stats != NULL) {
+            stats_add_token(stats, &token);
+        }
+    } while (token.type != TOKEN_EOF);
+    emit_diagnostics(out, NULL);
+    if (stats != NULL) {
+        stats_add_input(stats, token.start);  // EOF sits at the end of the input
+    }
+
+    stream_close(&stream);
+    if (file != stdin) {
+        fclose(file);
+    }
+    return 0;
+}
+
+/* Lex many files on a thread pool and print their tokens in the order given.
+ * args: [--threads N] [--list FILE] PATH... (files or directory trees) */
+static int analyze_batch(int argc, char **argv, Emitter *out, LexStats *stats) {
+    Batch batch;
+    batch_init(&batch);
+    int threads = 0;
+    for (int i = 0; i < argc; i++) {
+        int result;
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+            continue;
+        } else if (strcmp(argv[i], "--list") == 0 && i + 1 < argc) {
+            result = batch_add_list(&batch, argv[++i]);
+        } else {
+            result = batch_add_path(&batch, argv[i]);
+        }
+        if (result != 0) {
+            printf("Error reading %s\n", argv[i]);
+            batch_free(&batch);
+            return 1;
+        }
+    }
+
+    int failed = batch_run(&batch, threads, out, stats);
+    batch_free(&batch);
+    if (failed < 0) {
+        printf("Memory allocation failed.\n");
+    }
+    return failed != 0;
+}
+
+/* Lex a file on several threads and emit its tokens */
+static int analyze_parallel(const char *path, int threads, Emitter *out, LexStats *stats) {
+    SourceFile source;
+    if (source_open(&source, path) != 0) {
+        printf("Error opening file\n");
+        return 1;
+    }
+
+    out->title = path;
+    TokenList list;
+    LineIndex lines;
+    if (lex_parallel(source.data, source.length, threads, &list) != 0) {
+        printf("Memory allocation failed.\n");
+        source_close(&source);
+        return 1;
+    }
+    LineCursor cursor;
+    int indexed = line_index_build(&lines, source.data, source.length) == 0;
+    if (!indexed && line_cursor_init(&cursor, source.data, source.length) != 0) {
+        printf("Memory allocation failed.\n");
+        token_list_free(&list);
+        source_close(&source);
+        return 1;
+    }
+    out->lines = indexed ? &lines : NULL;
+    for (size_t i = 0; i < list.count; i++) {
+        const Token *token = &list.tokens[i];
+        if (indexed) {
+            emit_token(out, source.data, token);
+        } else {
+            // over 4 GiB the lines are counted as the tokens go by
+            emit_token_at(out, source.data + token->start, token, line_cursor_locate(&cursor, token->start));
+        }
+    }
+    emit_diagnostics(out, source.data);
+    if (stats != NULL) {
+        stats_add_input(stats, source.length);
+        for (size_t i = 0; i < list.count; i++) {
+            stats_add_token(stats, &list.tokens[i]);
+        }
+    }
+
+    out->lines = NULL;
+    if (indexed) {
+        line_index_free(&lines);
+    } else {
+        line_cursor_free(&cursor);
+    }
+    token_list_free(&list);
+    source_close(&source);
+    return 0;
+}
+
+/* Lex a file and save its tokens as a binary .tok file */
+static int write_tokfile(const char *output, const char *path, LexStats *stats) {
+    SourceFile source;
+    if (source_open(&source, path) != 0) {
+        printf("Error opening file\n");
+        return 1;
+    }
+    SymbolTable symbols;
+    TokenStream tokens;
+    LexerOptions options = {1, NULL, &symbols};
+    if (symbols_init(&symbols) != 0) {
+        printf("Memory allocation failed.\n");
+        source_close(&source);
+        return 1;
+    }
+    if (lex_all(source.data, source.length, &options, &tokens) != 0) {
+        printf("Memory allocation failed.\n");
+        symbols_free(&symbols);
+        source_close(&source);
+        return 1;
+    }
+
+    if (stats != NULL) {
+        stats_add_input(stats, source.length);
+        for (size_t i = 0; i < tokens.count; i++) {
+            Token token = token_stream_get(&tokens, i);
+            stats_add_token(stats, &token);
+        }
+    }
+
+    int result = 0;
+    FILE *out = fopen(output, "wb");
+    if (out == NULL || tokfile_write(out, source.data, source.length, &tokens, &symbols) != 0) {
+        printf("Error writing %s\n", output);
+        result = 1;
+    }
+    if (out != NULL && fclose(out) != 0 && result == 0) {
+        printf("Error writing %s\n", output);
+        result = 1;
+    }
+    token_stream_free(&tokens);
+    symbols_free(&symbols);
+    source_close(&source);
+    return result;
+}
+
+/* Emit the tokens stored in a .tok file, counting them into stats (NULL when not wanted) */
+static int read_tokfile(const char *path, Emitter *out, LexStats *stats) {
+    TokFile tok;
+    if (tokfile_open(&tok, path) != 0) {
+        printf("Error reading %s\n", path);
+        return 1;
+    }
+    LineIndex lines = tokfile_lines(&tok);
+    emit_file_header(out, path, tok.source, tok.source_length);
+    out->lines = &lines;
+    if (stats != NULL) {
+        stats_add_input(stats, tok.source_length);
+    }
+    int result = 0;
+    for (size_t i = 0; i < tok.count; i++) {
+        Token token;
+        if (tokfile_token(&tok, i, &token) != 0) {
+            printf("Error reading %s: token %zu is damaged\n", path, i);
+            result = 1;
+            break;
+        }
+        emit_token(out, tok.source, &token);
+        if (stats != NULL) {
+            stats_add_token(stats, &token);
+        }
+    }
+    emit_diagnostics(out, tok.source);
+    out->lines = NULL;
+    tokfile_close(&tok);
+    return result;
+}
+
+/* Run the mode selected by the arguments, emitting tokens to out and counting into stats
+ * (NULL when not wanted) */
+static int run(int argc, char **argv, Emitter *out, LexStats *stats) {
+    // --parallel THREADS FILE: lex FILE on up to THREADS threads
+    if (argc > 3 && strcmp(argv[1], "--parallel") == 0) {
+        return analyze_parallel(argv[3], atoi(argv[2]), out, stats);
+    }
+
+    // --stream [--window BYTES] [FILE]: lex FILE (default stdin) with bounded memory
+    if (argc > 1 && strcmp(argv[1], "--stream") == 0) {
+        size_t window = 0;
+        const char *path = "-";
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+                window = (size_t)strtoull(argv[++i], NULL, 10);
+            } else {
+                path = argv[i];
+            }
+        }
+        return analyze_stream(path, window, out, stats);
+    }
+
+    // --tok OUTPUT FILE: save the tokens of FILE in binary form; --read-tok FILE: emit them again
+    if (argc > 3 && strcmp(argv[1], "--tok") == 0) {
+        return write_tokfile(argv[2], argv[3], stats);
+    }
+    if (argc > 2 && strcmp(argv[1], "--read-tok") == 0) {
+        return read_tokfile(argv[2], out, stats);
+    }
+
+    // --batch [--threads N] [--list FILE] PATH...: lex many files, output in input order
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+        return analyze_batch(argc - 2, argv + 2, out, stats);
+    }
+
+    // PATH...: the same as --batch
+    if (argc > 1) {
+        return analyze_batch(argc - 1, argv + 1, out, stats);
+    }
+
+    // no arguments: the two test inputs
+    Batch batch;
+    batch_init(&batch);
+    if (batch_add_file(&batch, "../phase1-w25/test/input_correct_lex.txt", "Correct Input") != 0 ||
+        batch_add_file(&batch, "../phase1-w25/test/input_incorrect_lex.txt", "Incorrect Input") != 0) {
+        printf("Memory allocation failed.\n");
+        batch_free(&batch);
+        return 1;
+    }
+    int failed = batch_run(&batch, 0, out, stats);
+    batch_free(&batch);
+    return failed != 0;
+}
+
+int main(int argc, char **argv) {
+    // output options, accepted anywhere on the command line:
+    // --format text|json|csv, --no-echo (leave the source text out of file headers),
+    // --stats (summary on stderr), --stats-file FILE (Prometheus text format) and
+    // --max-errors N (lexical errors after each file's tokens, the first N of them; 0 for all)
+    // and -o/--output FILE (tokens to FILE instead of stdout)
+    EmitFormat format = EMIT_TEXT;
+    int echo = 1, want_stats = 0, defer_errors = 0;
+    size_t max_errors = 0;
+    const char *stats_file = NULL, *output = NULL;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            if (emit_parse_format(argv[++i], &format) != 0) {
+                printf("Unknown format %s (use text, json or csv)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--no-echo") == 0) {
+            echo = 0;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            want_stats = 1;
+        } else if (strcmp(argv[i], "--stats-file") == 0 && i + 1 < argc) {
+            stats_file = argv[++i];
+        } else if (strcmp(argv[i], "--max-errors") == 0 && i + 1 < argc) {
+            defer_errors = 1;
+            max_errors = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if ((strcmp(argv[i], "--output") == 0 || strcmp(argv[i], "-o") == 0) && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
+    int fd = STDOUT_FILENO;
+    if (output != NULL && (fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+        printf("Error writing %s\n", output);
+        return 1;
+    }
+    Emitter out;
+    if (emitter_init(&out, fd, format, echo) != 0) {
+        printf("Memory allocation failed.\n");
+        return 1;
+    }
+    if (defer_errors) {
+        emitter_defer_errors(&out, max_errors);
+    }
+    fflush(stdout);
+    LexStats stats;
+    stats_init(&stats);
+    struct timespec start, end;
+    timespec_get(&start, TIME_UTC);
+    int result = run(argc, argv, &out, want_stats || stats_file != NULL ? &stats : NULL);
+    // messages printed with printf are still in stdout's buffer, after everything emitted
+    if (emitter_close(&out) != 0 && result == 0) {
+        result = 1;
+    }
+    if (fd != STDOUT_FILENO && close(fd) != 0 && result == 0) {
+        printf("Error writing %s\n", output);
+        result = 1;
+    }
+    timespec_get(&end, TIME_UTC);
+    stats.seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) * 1e-9;
+
+    if (want_stats) {
+        stats_print(stderr, &stats);
+    }
+    if (stats_file != NULL && stats_write_prometheus(stats_file, &stats) != 0) {
+        fprintf(stderr, "Error writing %s\n", stats_file);
+        result = 1;
+    }
+    return result;
+}
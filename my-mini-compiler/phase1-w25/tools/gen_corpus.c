@@ -0,0 +1,361 @@
+/* gen_corpus.c
+ * Seeded generator of synthetic SeaPlus+ source for the lexer benchmarks.
+ *
+ * The output is made of whole statements, declarations, control blocks, prints and comments,
+ * in proportions set by the mix. The same seed, mix and size always give the same bytes.
+ * Strings are always closed, so one bad line never swallows the rest of the corpus.
+ *
+ * Usage: gen_corpus [--mix MIX] [--size BYTES] [--seed N] [OUTPUT]
+ *   MIX    mixed (default), identifier, operator, string, comment or error
+ *   BYTES  approximate output size, with an optional k, m or g suffix (default 1m)
+ *   OUTPUT file to write, standard output when missing or "-"
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define OUT_BUFFER (1 << 20)
+#define MAX_DEPTH 3
+
+/* How often each kind of statement comes up, in parts out of the row's total */
+enum { S_DECL, S_ASSIGN, S_CALL, S_BLOCK, S_PRINT, S_LINE_COMMENT, S_BLOCK_COMMENT, S_ERROR, S_KINDS };
+
+static const struct {
+    const char *name;
+    int weights[S_KINDS];
+    int expression_terms;       // most operands in one expression
+} mixes[] = {
+    //                decl assign call block print #  /**/ error
+    {"mixed",        {20,  25,    10,  15,   10,   8, 4,   0},  4},
+    {"identifier",   {15,  10,    60,  5,    0,    0, 0,   0},  3},
+    {"operator",     {10,  70,    0,   15,   0,    0, 0,   0},  12},
+    {"string",       {5,   5,     0,   5,    80,   0, 0,   0},  2},
+    {"comment",      {10,  10,    0,   5,    0,    40, 35, 0},  3},
+    {"error",        {10,  15,    5,   10,   5,    5, 0,   50}, 4},
+};
+#define NUM_MIXES ((int)(sizeof(mixes) / sizeof(mixes[0])))
+
+static const char *types[] = {"int", "float", "double", "char", "bool", "string"};
+static const char *names[] = {
+    "count", "total", "index", "value", "result", "buffer", "offset", "length", "node", "left",
+    "right", "parent", "child", "key", "item", "sum", "delta", "ratio", "limit", "step",
+    "state", "flag", "mask", "cursor", "depth", "width", "height", "score", "alpha", "beta",
+    "gamma", "theta"
+};
+static const char *binary_ops[] = {
+    "+", "-", "*", "/", "%", "==", "!=", "<", "<=", ">", ">=", "<<", ">>", "<<<", ">>>",
+    "||", "&&", "^", "^^", "|", "&?"
+};
+static const char *assign_ops[] = {"=", "+=", "-=", "*=", "/=", "%="};
+static const char *words[] = {
+    "lorem", "ipsum", "dolor", "sit", "amet", "SeaPlus+", "lexer", "token", "stream", "value",
+    "(TAB HERE)", "HAPPY", "BIRTHDAY", "x == 5", "{ brackets }", "semi;colon"
+};
+static const char *escapes[] = {"\\n", "\\t", "\\\\", "\\\"", "\\'", "\\r"};
+
+#define COUNT(array) (sizeof(array) / sizeof(array[0]))
+
+typedef struct {
+    FILE *file;
+    char buffer[OUT_BUFFER];
+    size_t fill;
+    uint64_t written;
+    uint64_t rng;
+    int mix;
+} Gen;
+
+static uint32_t next_random(Gen *g) {
+    // xorshift64*
+    g->rng ^= g->rng >> 12;
+    g->rng ^= g->rng << 25;
+    g->rng ^= g->rng >> 27;
+    return (uint32_t)((g->rng * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static uint32_t below(Gen *g, uint32_t n) {
+    return next_random(g) % n;
+}
+
+static void flush(Gen *g) {
+    if (fwrite(g->buffer, 1, g->fill, g->file) != g->fill) {
+        perror("gen_corpus");
+        exit(1);
+    }
+    g->written += g->fill;
+    g->fill = 0;
+}
+
+static void put(Gen *g, const char *text) {
+    size_t length = strlen(text);
+    if (g->fill + length > OUT_BUFFER) {
+        flush(g);
+    }
+    memcpy(g->buffer + g->fill, text, length);
+    g->fill += length;
+}
+
+static void put_char(Gen *g, char c) {
+    if (g->fill == OUT_BUFFER) {
+        flush(g);
+    }
+    g->buffer[g->fill++] = c;
+}
+
+static void put_number(Gen *g, uint32_t n) {
+    char digits[16];
+    snprintf(digits, sizeof(digits), "%u", n);
+    put(g, digits);
+}
+
+static void indent(Gen *g, int depth) {
+    for (int i = 0; i < depth; i++) {
+        put(g, "    ");
+    }
+}
+
+// "total", "total_17" or "total2": never a keyword
+static void identifier(Gen *g) {
+    put(g, names[below(g, COUNT(names))]);
+    switch (below(g, 3)) {
+        case 0:
+            put_char(g, '_');
+            put_number(g, below(g, 1000));
+            break;
+        case 1:
+            put_number(g, below(g, 10));
+            break;
+    }
+}
+
+static void operand(Gen *g, int depth) {
+    uint32_t pick = below(g, 10);
+    if (pick < 5) {
+        identifier(g);
+    } else if (pick < 8) {
+        put_number(g, below(g, 100000));
+    } else if (pick < 9 && depth < MAX_DEPTH) {
+        put_char(g, '(');
+        identifier(g);
+        put(g, " + ");
+        put_number(g, below(g, 100));
+        put_char(g, ')');
+    } else {
+        put(g, below(g, 2) ? "$" : "!");
+        identifier(g);
+    }
+}
+
+static void expression(Gen *g, int depth) {
+    int terms = 1 + (int)below(g, (uint32_t)mixes[g->mix].expression_terms);
+    operand(g, depth);
+    for (int t = 1; t < terms; t++) {
+        put_char(g, ' ');
+        put(g, binary_ops[below(g, COUNT(binary_ops))]);
+        put_char(g, ' ');
+        operand(g, depth);
+    }
+}
+
+static void string_literal(Gen *g) {
+    int parts = 1 + (int)below(g, 12);
+    put_char(g, '"');
+    for (int i = 0; i < parts; i++) {
+        if (i > 0) {
+            put_char(g, ' ');
+        }
+        put(g, below(g, 5) == 0 ? escapes[below(g, COUNT(escapes))] : words[below(g, COUNT(words))]);
+    }
+    put_char(g, '"');
+}
+
+static void statement(Gen *g, int depth);
+
+static void block(Gen *g, int depth) {
+    static const char *heads[] = {"if", "while", "until", "for"};
+    indent(g, depth);
+    put(g, heads[below(g, COUNT(heads))]);
+    put_char(g, '(');
+    expression(g, MAX_DEPTH);
+    put(g, "){\n");
+    int body = 1 + (int)below(g, 4);
+    for (int i = 0; i < body; i++) {
+        statement(g, depth + 1);
+    }
+    indent(g, depth);
+    put(g, "}\n");
+}
+
+/* Lines with lexical errors that recover within the line */
+static void error_line(Gen *g, int depth) {
+    static const char *bad_chars[] = {"@", "`", "~", "?", ":", "\\"};
+    indent(g, depth);
+    identifier(g);
+    switch (below(g, 5)) {
+        case 0:
+            put(g, " = ");
+            put(g, bad_chars[below(g, COUNT(bad_chars))]);
+            identifier(g);
+            break;
+        case 1:
+            put(g, " = a + * b");       // consecutive operators
+            break;
+        case 2:
+            put(g, " = 'ab'");          // unterminated char
+            break;
+        case 3:
+            put(g, " = \"bad \\q escape\"");
+            break;
+        default:
+            put(g, " = '\\z'");         // invalid escape in a char
+            break;
+    }
+    put(g, ";\n");
+}
+
+static void statement(Gen *g, int depth) {
+    int total = 0;
+    for (int k = 0; k < S_KINDS; k++) {
+        total += mixes[g->mix].weights[k];
+    }
+    int pick = (int)below(g, (uint32_t)total);
+    int kind = 0;
+    while (pick >= mixes[g->mix].weights[kind]) {
+        pick -= mixes[g->mix].weights[kind++];
+    }
+    if (kind == S_BLOCK && depth >= MAX_DEPTH) {
+        kind = S_ASSIGN;
+    }
+
+    switch (kind) {
+        case S_DECL:
+            indent(g, depth);
+            put(g, types[below(g, COUNT(types))]);
+            put_char(g, ' ');
+            identifier(g);
+            put(g, " = ");
+            expression(g, 0);
+            put(g, ";\n");
+            break;
+        case S_ASSIGN:
+            indent(g, depth);
+            identifier(g);
+            put_char(g, ' ');
+            put(g, assign_ops[below(g, COUNT(assign_ops))]);
+            put_char(g, ' ');
+            expression(g, 0);
+            put(g, ";\n");
+            break;
+        case S_CALL: {
+            int args = 1 + (int)below(g, 8);
+            indent(g, depth);
+            identifier(g);
+            put_char(g, '(');
+            for (int i = 0; i < args; i++) {
+                if (i > 0) {
+                    put(g, ", ");
+                }
+                identifier(g);
+            }
+            put(g, ");\n");
+            break;
+        }
+        case S_BLOCK:
+            block(g, depth);
+            break;
+        case S_PRINT:
+            indent(g, depth);
+            put(g, "print(");
+            string_literal(g);
+            put(g, ");\n");
+            break;
+        case S_LINE_COMMENT:
+            indent(g, depth);
+            put(g, "# ");
+            for (int i = 0, n = 2 + (int)below(g, 10); i < n; i++) {
+                put(g, words[below(g, COUNT(words))]);
+                put_char(g, ' ');
+            }
+            put_char(g, '\n');
+            break;
+        case S_BLOCK_COMMENT:
+            indent(g, depth);
+            put(g, "/* ");
+            for (int line = 0, lines = 1 + (int)below(g, 4); line < lines; line++) {
+                for (int i = 0, n = 2 + (int)below(g, 8); i < n; i++) {
+                    put(g, words[below(g, COUNT(words))]);
+                    put_char(g, ' ');
+                }
+                put_char(g, '\n');
+                indent(g, depth);
+            }
+            put(g, "*/\n");
+            break;
+        case S_ERROR:
+            error_line(g, depth);
+            break;
+    }
+}
+
+static int parse_size(const char *text, uint64_t *size) {
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    switch (*end) {
+        case 'k': case 'K': value <<= 10; end++; break;
+        case 'm': case 'M': value <<= 20; end++; break;
+        case 'g': case 'G': value <<= 30; end++; break;
+    }
+    *size = value;
+    return end != text && *end == '\0' ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+    static Gen g;
+    const char *output = "-";
+    const char *mix = "mixed";
+    uint64_t size = 1 << 20;
+    uint64_t seed = 458;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mix") == 0 && i + 1 < argc) {
+            mix = argv[++i];
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (parse_size(argv[++i], &size) != 0) {
+                fprintf(stderr, "gen_corpus: bad size %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            output = argv[i];
+        }
+    }
+
+    g.mix = -1;
+    for (int m = 0; m < NUM_MIXES; m++) {
+        if (strcmp(mixes[m].name, mix) == 0) {
+            g.mix = m;
+        }
+    }
+    if (g.mix < 0) {
+        fprintf(stderr, "gen_corpus: unknown mix %s (mixed, identifier, operator, string, comment, error)\n", mix);
+        return 1;
+    }
+    g.rng = seed * 0x9E3779B97F4A7C15ULL + 1;  // never zero, which xorshift cannot leave
+    g.file = strcmp(output, "-") == 0 ? stdout : fopen(output, "wb");
+    if (g.file == NULL) {
+        perror(output);
+        return 1;
+    }
+
+    // whole statements until the size is reached
+    while (g.written + g.fill < size) {
+        statement(&g, 0);
+    }
+    flush(&g);
+    if (g.file != stdout && fclose(g.file) != 0) {
+        perror(output);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+/* gen_keywords.c
+ * Build-time generator for the keyword perfect hash used by iskeyword().
+ *
+ * The lexer feeds every identifier character through
+ *     h = h * KEYWORD_HASH_MULT + c
+ * while it is already walking the lexeme, so the only work left once the
+ * identifier ends is one table load and (at most) one memcmp.  This tool
+ * searches for a multiplier/shift pair that maps every keyword in
+ * keywords.def to its own slot and writes the parameters out as a header.
+ *
+ * Usage: gen_keywords <output header>
+ */
+#include <stdio.h>
+#include <string.h>
+
+static const char *keywords[] = {
+#define KEYWORD(word) word,
+#include "keywords.def"
+#undef KEYWORD
+};
+
+#define NUM_WORDS ((int)(sizeof(keywords) / sizeof(keywords[0])))
+
+static unsigned int hash_word(const char *word, unsigned int mult) {
+    unsigned int h = 0;
+    for (const char *p = word; *p != '\0'; p++) {
+        h = h * mult + (unsigned char)*p;
+    }
+    return h;
+}
+
+/* Try to place every keyword in its own slot; fills slots[] on success */
+static int try_params(unsigned int mult, int shift, int size, signed char *slots) {
+    memset(slots, -1, (size_t)size);
+    for (int i = 0; i < NUM_WORDS; i++) {
+        unsigned int slot = (hash_word(keywords[i], mult) >> shift) & (unsigned int)(size - 1);
+        if (slots[slot] != -1) {
+            return 0;  // collision
+        }
+        slots[slot] = (signed char)i;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <output header>\n", argv[0]);
+        return 1;
+    }
+
+    signed char slots[256];
+    // smallest power-of-two table first, then the first multiplier/shift that works
+    for (int size = 32; size <= 256; size *= 2) {
+        for (unsigned int mult = 3; mult < 65536; mult += 2) {
+            for (int shift = 0; shift < 24; shift++) {
+                if (!try_params(mult, shift, size, slots)) {
+                    continue;
+                }
+
+                FILE *out = fopen(argv[1], "w");
+                if (out == NULL) {
+                    fprintf(stderr, "gen_keywords: cannot open %s\n", argv[1]);
+                    return 1;
+                }
+                fprintf(out, "/* keyword_hash.h -- generated by gen_keywords from keywords.def, do not edit */\n");
+                fprintf(out, "#ifndef KEYWORD_HASH_H\n#define KEYWORD_HASH_H\n\n");
+                fprintf(out, "/* Keywords in keywords.def */\n");
+                fprintf(out, "#define KEYWORD_COUNT %d\n\n", NUM_WORDS);
+                fprintf(out, "#define KEYWORD_HASH_INIT 0u\n");
+                fprintf(out, "#define KEYWORD_HASH_MULT %uu\n", mult);
+                fprintf(out, "#define KEYWORD_HASH_SHIFT %d\n", shift);
+                fprintf(out, "#define KEYWORD_TABLE_SIZE %d\n\n", size);
+                fprintf(out, "/* Index into keywords[] for every slot, -1 when the slot is empty */\n");
+                fprintf(out, "#define KEYWORD_SLOTS_INIT {");
+                for (int i = 0; i < size; i++) {
+                    fprintf(out, "%s%d", (i % 16 == 0) ? " \\\n    " : " ", slots[i]);
+                    if (i != size - 1) {
+                        fputc(',', out);
+                    }
+                }
+                fprintf(out, " \\\n}\n\n#endif /* KEYWORD_HASH_H */\n");
+                fclose(out);
+                return 0;
+            }
+        }
+    }
+
+    fprintf(stderr, "gen_keywords: no collision-free parameters found\n");
+    return 1;
+}
@@ -0,0 +1,175 @@
+/* gen_pow5.c
+ * Build-time generator for the powers of five used by the float parser (number.c).
+ *
+ * Entry q - POW5_MIN_EXPONENT holds the top 128 bits of 5^q, scaled into [2^127, 2^128):
+ * truncated for q >= 0 and rounded up for q < 0, where 5^q is the reciprocal 2^b / 5^-q
+ * for a b large enough that the truncated quotient has 128 correct bits. The bignums here
+ * are only ever a couple of thousand bits long, so plain shift-and-subtract is enough.
+ *
+ * Usage: gen_pow5 <output header>
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MIN_EXPONENT (-342)
+#define MAX_EXPONENT 308
+#define LIMBS 64                // 2048 bits, 2^b for q = -342 needs about 1720
+
+typedef struct {
+    uint32_t limb[LIMBS];       // little-endian
+} Big;
+
+static void big_set(Big *a, uint32_t value) {
+    memset(a, 0, sizeof(*a));
+    a->limb[0] = value;
+}
+
+static void big_mul_small(Big *a, uint32_t factor) {
+    uint64_t carry = 0;
+    for (int i = 0; i < LIMBS; i++) {
+        uint64_t product = (uint64_t)a->limb[i] * factor + carry;
+        a->limb[i] = (uint32_t)product;
+        carry = product >> 32;
+    }
+}
+
+/* Number of significant bits */
+static int big_bits(const Big *a) {
+    for (int i = LIMBS - 1; i >= 0; i--) {
+        if (a->limb[i] != 0) {
+            return i * 32 + 32 - __builtin_clz(a->limb[i]);
+        }
+    }
+    return 0;
+}
+
+static void big_set_bit(Big *a, int bit) {
+    a->limb[bit / 32] |= 1u << (bit % 32);
+}
+
+static void big_shl1(Big *a) {
+    for (int i = LIMBS - 1; i > 0; i--) {
+        a->limb[i] = (a->limb[i] << 1) | (a->limb[i - 1] >> 31);
+    }
+    a->limb[0] <<= 1;
+}
+
+static void big_shr(Big *a, int shift) {
+    for (int s = 0; s < shift; s++) {
+        for (int i = 0; i < LIMBS - 1; i++) {
+            a->limb[i] = (a->limb[i] >> 1) | (a->limb[i + 1] << 31);
+        }
+        a->limb[LIMBS - 1] >>= 1;
+    }
+}
+
+static int big_compare(const Big *a, const Big *b) {
+    for (int i = LIMBS - 1; i >= 0; i--) {
+        if (a->limb[i] != b->limb[i]) {
+            return a->limb[i] < b->limb[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static void big_sub(Big *a, const Big *b) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < LIMBS; i++) {
+        uint64_t difference = (uint64_t)a->limb[i] - b->limb[i] - borrow;
+        a->limb[i] = (uint32_t)difference;
+        borrow = (difference >> 32) & 1u;
+    }
+}
+
+static void big_add_one(Big *a) {
+    for (int i = 0; i < LIMBS && ++a->limb[i] == 0; i++) {
+    }
+}
+
+/* quotient = 2^power / divisor, by long division one bit at a time */
+static void big_divide_power2(Big *quotient, int power, const Big *divisor) {
+    Big remainder;
+    big_set(&remainder, 0);
+    big_set(quotient, 0);
+    for (int bit = power; bit >= 0; bit--) {
+        big_shl1(&remainder);
+        remainder.limb[0] |= bit == power;
+        if (big_compare(&remainder, divisor) >= 0) {
+            big_sub(&remainder, divisor);
+            big_set_bit(quotient, bit);
+        }
+    }
+}
+
+/* The top 128 bits of a, which has at most 128 + LIMBS*32 bits */
+static void big_top128(Big *a, uint64_t *high, uint64_t *low) {
+    int bits = big_bits(a);
+    if (bits > 128) {
+        big_shr(a, bits - 128);
+    }
+    *high = ((uint64_t)a->limb[3] << 32) | a->limb[2];
+    *low = ((uint64_t)a->limb[1] << 32) | a->limb[0];
+}
+
+static void power_of_five(int q, uint64_t *high, uint64_t *low) {
+    Big power;
+    big_set(&power, 1);
+    for (int i = 0; i < (q < 0 ? -q : q); i++) {
+        big_mul_small(&power, 5);
+    }
+    if (q >= 0) {
+        // move the leading bit up to bit 127, or truncate down to it
+        int bits = big_bits(&power);
+        for (; bits < 128; bits++) {
+            big_shl1(&power);
+        }
+        big_top128(&power, high, low);
+        return;
+    }
+
+    // z: the least z with 2^z >= 5^-q
+    int z = big_bits(&power);
+    Big below;
+    big_set(&below, 0);
+    big_set_bit(&below, z - 1);
+    if (big_compare(&below, &power) == 0) {
+        z--;
+    }
+    int b = q >= -27 ? z + 127 : 2 * z + 128;
+    Big quotient;
+    big_divide_power2(&quotient, b, &power);
+    big_add_one(&quotient);
+    big_top128(&quotient, high, low);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <output header>\n", argv[0]);
+        return 1;
+    }
+    FILE *out = fopen(argv[1], "w");
+    if (out == NULL) {
+        fprintf(stderr, "gen_pow5: cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(out, "/* pow5_table.h -- generated by gen_pow5, do not edit */\n");
+    fprintf(out, "#ifndef POW5_TABLE_H\n#define POW5_TABLE_H\n\n");
+    fprintf(out, "#define POW5_MIN_EXPONENT (%d)\n", MIN_EXPONENT);
+    fprintf(out, "#define POW5_MAX_EXPONENT %d\n\n", MAX_EXPONENT);
+    fprintf(out, "/* 5^q scaled into [2^127, 2^128): high 64 bits, then low 64 bits, for q from\n");
+    fprintf(out, " * POW5_MIN_EXPONENT to POW5_MAX_EXPONENT */\n");
+    fprintf(out, "#define POW5_TABLE_INIT { \\\n");
+    for (int q = MIN_EXPONENT; q <= MAX_EXPONENT; q++) {
+        uint64_t high, low;
+        power_of_five(q, &high, &low);
+        fprintf(out, "    0x%016llxu, 0x%016llxu, \\\n", (unsigned long long)high, (unsigned long long)low);
+    }
+    fprintf(out, "}\n\n#endif /* POW5_TABLE_H */\n");
+    if (fclose(out) != 0) {
+        fprintf(stderr, "gen_pow5: cannot write %s\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,493 @@
+/* gen_scanner.c
+ * Build-time generator for the table-driven scanner in lexer.c.
+ *
+ * Reads the token rules in tokens.spec, builds a DFA that finds the longest rule matching at
+ * the current position (subset construction over the rule patterns), folds the 256 input
+ * bytes into classes that behave the same in every state, and writes the class table, the
+ * transition table and the rule actions out as a header. The scanner's hot loop is then
+ *     state = scan_next[state][scan_class[byte]]
+ * and nothing about the language is spelled out by hand in lexer.c.
+ *
+ * Operators also get a direct lookup table: the DFA is run ahead of time on every
+ * combination of three operator characters, so the scanner finds the longest operator
+ * with three class loads and one table load instead of a loop.
+ *
+ * Usage: gen_scanner <tokens.spec> <output header>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_RULES 128
+#define MAX_ITEMS 16
+#define MAX_POSITIONS 512       // NFA positions: one per rule item, plus one per rule end
+#define MAX_STATES 255          // states are stored in unsigned char, 0 is the dead state
+#define SET_WORDS (MAX_POSITIONS / 64)
+#define OPERATOR_BYTES 3        // longest operator the operator table can hold
+
+/* Rule kinds in tokens.spec and the SCAN_* action each one is written out as */
+static const char *kinds[] = {
+    "blank", "line_comment", "block_comment", "number", "identifier",
+    "string", "char", "operator", "delimiter", "special"
+};
+static const char *actions[] = {
+    "SCAN_BLANK", "SCAN_LINE_COMMENT", "SCAN_BLOCK_COMMENT", "SCAN_NUMBER", "SCAN_IDENTIFIER",
+    "SCAN_STRING", "SCAN_CHAR", "SCAN_OPERATOR", "SCAN_DELIMITER", "SCAN_SPECIAL"
+};
+#define NUM_KINDS ((int)(sizeof(kinds) / sizeof(kinds[0])))
+
+/* One pattern item: a set of bytes, matched once or (star) any number of times */
+typedef struct {
+    unsigned char bytes[256];
+    int star;
+} Item;
+
+typedef struct {
+    int kind;
+    char last_type;             // '\0' when the rule gives none
+    char text[64];              // the pattern as written, for the generated comments
+    Item items[MAX_ITEMS];
+    int count;
+    int base;                   // NFA position of the rule's first item
+} Rule;
+
+typedef struct {
+    unsigned long long bits[SET_WORDS];
+} PositionSet;
+
+static Rule rules[MAX_RULES];
+static int num_rules;
+static int num_positions;
+static unsigned char follows_operator[256];
+
+static PositionSet states[MAX_STATES + 1];
+static int num_states;
+static unsigned char next_state[MAX_STATES + 1][256];
+static int accept_rule[MAX_STATES + 1];
+
+static int line_number;
+
+_Noreturn static void fail(const char *message, const char *detail) {
+    fprintf(stderr, "gen_scanner: tokens.spec:%d: %s%s%s\n", line_number, message,
+            detail != NULL ? ": " : "", detail != NULL ? detail : "");
+    exit(1);
+}
+
+/* Decode one (possibly escaped) pattern character, advancing *p */
+static unsigned char pattern_char(const char **p) {
+    char c = *(*p)++;
+    if (c != '\\') {
+        return (unsigned char)c;
+    }
+    c = *(*p)++;
+    switch (c) {
+        case 's': return ' ';
+        case 't': return '\t';
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case '\0': fail("pattern ends in \\", NULL);
+        default: return (unsigned char)c;
+    }
+}
+
+static void parse_pattern(Rule *rule, const char *pattern) {
+    const char *p = pattern;
+    while (*p != '\0') {
+        if (rule->count == MAX_ITEMS) {
+            fail("pattern too long", pattern);
+        }
+        Item *item = &rule->items[rule->count++];
+        memset(item, 0, sizeof(*item));
+
+        if (*p != '[') {
+            item->bytes[pattern_char(&p)] = 1;
+            continue;
+        }
+        // [set] with a-z ranges, optionally repeated
+        p++;
+        while (*p != ']') {
+            if (*p == '\0') {
+                fail("unclosed [", pattern);
+            }
+            unsigned char low = pattern_char(&p);
+            unsigned char high = low;
+            if (*p == '-' && p[1] != ']' && p[1] != '\0') {
+                p++;
+                high = pattern_char(&p);
+            }
+            for (int c = low; c <= high; c++) {
+                item->bytes[c] = 1;
+            }
+        }
+        p++;
+        if (*p == '*') {
+            item->star = 1;
+            p++;
+        }
+    }
+    if (rule->count == 0) {
+        fail("empty pattern", NULL);
+    }
+    for (int i = 0; i < rule->count; i++) {
+        if (rule->items[i].bytes[0]) {
+            fail("patterns cannot match the NUL terminator", pattern);
+        }
+    }
+}
+
+static void read_spec(const char *path) {
+    FILE *spec = fopen(path, "r");
+    if (spec == NULL) {
+        fprintf(stderr, "gen_scanner: cannot open %s\n", path);
+        exit(1);
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), spec) != NULL) {
+        line_number++;
+        char kind[32], pattern[64], last[8];
+        int fields = sscanf(line, "%31s %63s %7s", kind, pattern, last);
+        if (fields <= 0 || (kind[0] == '/' && kind[1] == '/')) {
+            continue;  // blank line or comment
+        }
+        if (fields < 2) {
+            fail("missing pattern", kind);
+        }
+        if (strcmp(kind, "follows_operator") == 0) {
+            for (const char *p = pattern; *p != '\0';) {
+                follows_operator[pattern_char(&p)] = 1;
+            }
+            continue;
+        }
+
+        int k = 0;
+        while (k < NUM_KINDS && strcmp(kind, kinds[k]) != 0) {
+            k++;
+        }
+        if (k == NUM_KINDS) {
+            fail("unknown rule kind", kind);
+        }
+        if (num_rules == MAX_RULES) {
+            fail("too many rules", NULL);
+        }
+        Rule *rule = &rules[num_rules++];
+        rule->kind = k;
+        rule->last_type = fields == 3 ? last[0] : '\0';
+        snprintf(rule->text, sizeof(rule->text), "%s", pattern);
+        parse_pattern(rule, pattern);
+        rule->base = num_positions;
+        num_positions += rule->count + 1;
+        if (num_positions > MAX_POSITIONS) {
+            fail("rules too large", NULL);
+        }
+    }
+    fclose(spec);
+}
+
+static void set_add(PositionSet *set, int position) {
+    set->bits[position / 64] |= 1ull << (position % 64);
+}
+
+static int set_has(const PositionSet *set, int position) {
+    return (set->bits[position / 64] >> (position % 64)) & 1;
+}
+
+/* Add the positions reachable by skipping starred items */
+static void closure(PositionSet *set) {
+    for (int r = 0; r < num_rules; r++) {
+        const Rule *rule = &rules[r];
+        for (int i = 0; i < rule->count; i++) {
+            if (rule->items[i].star && set_has(set, rule->base + i)) {
+                set_add(set, rule->base + i + 1);
+            }
+        }
+    }
+}
+
+static int state_for(const PositionSet *set) {
+    int empty = 1;
+    for (int w = 0; w < SET_WORDS; w++) {
+        empty &= set->bits[w] == 0;
+    }
+    if (empty) {
+        return 0;
+    }
+    for (int s = 1; s <= num_states; s++) {
+        if (memcmp(&states[s], set, sizeof(*set)) == 0) {
+            return s;
+        }
+    }
+    if (num_states == MAX_STATES) {
+        fprintf(stderr, "gen_scanner: more than %d DFA states\n", MAX_STATES);
+        exit(1);
+    }
+    states[++num_states] = *set;
+    return num_states;
+}
+
+static void build_dfa(void) {
+    PositionSet start;
+    memset(&start, 0, sizeof(start));
+    for (int r = 0; r < num_rules; r++) {
+        set_add(&start, rules[r].base);
+    }
+    closure(&start);
+    state_for(&start);  // state 1
+
+    // states are appended while the loop runs, every one gets its row filled in
+    for (int s = 1; s <= num_states; s++) {
+        accept_rule[s] = -1;
+        for (int r = num_rules - 1; r >= 0; r--) {
+            if (set_has(&states[s], rules[r].base + rules[r].count)) {
+                accept_rule[s] = r;  // earliest rule wins a tie
+            }
+        }
+        for (int c = 0; c < 256; c++) {
+            PositionSet moved;
+            memset(&moved, 0, sizeof(moved));
+            for (int r = 0; r < num_rules; r++) {
+                const Rule *rule = &rules[r];
+                for (int i = 0; i < rule->count; i++) {
+                    if (set_has(&states[s], rule->base + i) && rule->items[i].bytes[c]) {
+                        set_add(&moved, rule->base + i + (rule->items[i].star ? 0 : 1));
+                    }
+                }
+            }
+            closure(&moved);
+            next_state[s][c] = (unsigned char)state_for(&moved);
+        }
+    }
+    if (accept_rule[1] >= 0) {
+        fprintf(stderr, "gen_scanner: a rule matches the empty string\n");
+        exit(1);
+    }
+    // the scanner takes the rule of the state where the DFA dies and never backs up, which
+    // is only right when every prefix of a match is itself matched by some rule
+    for (int s = 2; s <= num_states; s++) {
+        if (accept_rule[s] < 0) {
+            fprintf(stderr, "gen_scanner: a prefix of a rule matches no rule, the scanner "
+                            "would have to back up\n");
+            exit(1);
+        }
+    }
+}
+
+static int bytes_equivalent(int a, int b) {
+    for (int s = 1; s <= num_states; s++) {
+        if (next_state[s][a] != next_state[s][b]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Operator classes: one per DFA class that occurs in an operator, 0 for all other bytes */
+static int build_operator_classes(const int *byte_class, int *op_class, int *op_representative) {
+    int num_op_classes = 1;
+    int class_map[256];
+    memset(class_map, 0, sizeof(class_map));
+    op_representative[0] = 0;  // NUL stands for every byte no operator uses
+    for (int c = 0; c < 256; c++) {
+        int used = 0;
+        for (int r = 0; r < num_rules && !used; r++) {
+            if (strcmp(kinds[rules[r].kind], "operator") != 0) {
+                continue;
+            }
+            for (int i = 0; i < rules[r].count; i++) {
+                used |= rules[r].items[i].bytes[c];
+            }
+        }
+        if (used && class_map[byte_class[c]] == 0) {
+            op_representative[num_op_classes] = c;
+            class_map[byte_class[c]] = num_op_classes++;
+        }
+    }
+    for (int c = 0; c < 256; c++) {
+        op_class[c] = class_map[byte_class[c]];
+    }
+    return num_op_classes;
+}
+
+/* Bytes in operator class 0 are all looked up as NUL, which is only right if every one of
+ * them ends a match that starts with an operator character, just like NUL does */
+static void check_operator_classes(const int *op_class) {
+    for (int a = 1; a < 256; a++) {
+        int first = op_class[a] != 0 ? next_state[1][a] : 0;
+        for (int b = 1; first != 0 && b < 256; b++) {
+            int second = next_state[first][b];
+            if (second != 0 && op_class[b] == 0) {
+                fprintf(stderr, "gen_scanner: byte %d continues an operator but is in no operator\n", b);
+                exit(1);
+            }
+            for (int c = 1; second != 0 && c < 256; c++) {
+                if (next_state[second][c] != 0 && op_class[c] == 0) {
+                    fprintf(stderr, "gen_scanner: byte %d continues an operator but is in no operator\n", c);
+                    exit(1);
+                }
+            }
+        }
+    }
+}
+
+/* Longest operator for three operator classes: rule index + 1, or 0 when the DFA has to
+ * decide (the text is no operator, or a longer rule may still match) */
+static int operator_entry(const int *op_representative, int a, int b, int c) {
+    if (a == 0) {
+        return 0;
+    }
+    int path[OPERATOR_BYTES] = {op_representative[a], op_representative[b], op_representative[c]};
+    int state = 1;
+    for (int i = 0; i < OPERATOR_BYTES; i++) {
+        int next = next_state[state][path[i]];
+        if (next == 0) {
+            break;
+        }
+        state = next;
+        if (i == OPERATOR_BYTES - 1) {
+            for (int x = 0; x < 256; x++) {
+                if (next_state[state][x] != 0) {
+                    return 0;  // the match can grow past the table
+                }
+            }
+        }
+    }
+    int rule = accept_rule[state];
+    if (rule < 0 || strcmp(kinds[rules[rule].kind], "operator") != 0) {
+        return 0;
+    }
+    return rule + 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <tokens.spec> <output header>\n", argv[0]);
+        return 1;
+    }
+    read_spec(argv[1]);
+    build_dfa();
+
+    // byte classes: bytes that move every state the same way share a class. NUL never
+    // starts or continues a match, so class 0 is the class that leads nowhere
+    int byte_class[256];
+    int representative[256];
+    int num_classes = 0;
+    for (int c = 0; c < 256; c++) {
+        byte_class[c] = -1;
+        for (int k = 0; k < num_classes; k++) {
+            if (bytes_equivalent(c, representative[k])) {
+                byte_class[c] = k;
+                break;
+            }
+        }
+        if (byte_class[c] < 0) {
+            representative[num_classes] = c;
+            byte_class[c] = num_classes++;
+        }
+    }
+
+    int op_class[256];
+    int op_representative[256];
+    int num_op_classes = build_operator_classes(byte_class, op_class, op_representative);
+    check_operator_classes(op_class);
+
+    FILE *out = fopen(argv[2], "w");
+    if (out == NULL) {
+        fprintf(stderr, "gen_scanner: cannot open %s\n", argv[2]);
+        return 1;
+    }
+    fprintf(out, "/* scanner_tables.h -- generated by gen_scanner from tokens.spec, do not edit */\n");
+    fprintf(out, "#ifndef SCANNER_TABLES_H\n#define SCANNER_TABLES_H\n\n");
+    fprintf(out, "#define SCAN_STATES %d     // state 0 is dead, state 1 is the start\n", num_states + 1);
+    fprintf(out, "#define SCAN_CLASSES %d\n", num_classes);
+    fprintf(out, "#define SCAN_START 1\n\n");
+
+    fprintf(out, "/* What the scanner does with a match, one per rule kind in tokens.spec */\n");
+    fprintf(out, "enum {\n");
+    for (int k = 0; k < NUM_KINDS; k++) {
+        fprintf(out, "    %s,\n", actions[k]);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "/* Input byte -> character class */\n");
+    fprintf(out, "static const unsigned char scan_class[256] = {");
+    for (int c = 0; c < 256; c++) {
+        fprintf(out, "%s%d%s", c % 16 == 0 ? "\n    " : "", byte_class[c], c != 255 ? ", " : "");
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "/* [state][class] -> next state, 0 once no rule can match any further */\n");
+    fprintf(out, "static const unsigned char scan_next[SCAN_STATES][SCAN_CLASSES] = {\n");
+    for (int s = 0; s <= num_states; s++) {
+        fprintf(out, "    {");
+        for (int k = 0; k < num_classes; k++) {
+            fprintf(out, "%d%s", s == 0 ? 0 : next_state[s][representative[k]],
+                    k != num_classes - 1 ? ", " : "");
+        }
+        fprintf(out, "},\n");
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "/* Rule matched by the text read so far in each state: index + 1, 0 for none */\n");
+    fprintf(out, "static const unsigned char scan_accept[SCAN_STATES] = {");
+    for (int s = 0; s <= num_states; s++) {
+        fprintf(out, "%s%d%s", s % 16 == 0 ? "\n    " : "", s == 0 ? 0 : accept_rule[s] + 1,
+                s != num_states ? ", " : "");
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "/* Action, last_token_type and length (0 when it varies) of every rule */\n");
+    fprintf(out, "static const struct {\n    unsigned char action;\n    char last_type;\n"
+                 "    unsigned char length;\n} scan_rules[%d] = {\n", num_rules);
+    for (int r = 0; r < num_rules; r++) {
+        char entry[64];
+        char last[8] = "0";
+        int length = rules[r].count;
+        for (int i = 0; i < rules[r].count; i++) {
+            if (rules[r].items[i].star) {
+                length = 0;
+            }
+        }
+        if (rules[r].last_type != '\0') {
+            snprintf(last, sizeof(last), "'%s%c'",
+                     rules[r].last_type == '\'' || rules[r].last_type == '\\' ? "\\" : "",
+                     rules[r].last_type);
+        }
+        snprintf(entry, sizeof(entry), "{%s, %s, %d},", actions[rules[r].kind], last, length);
+        fprintf(out, "    %-31s// %s %s\n", entry, kinds[rules[r].kind], rules[r].text);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "/* Bytes that may start an operator right after another operator */\n");
+    fprintf(out, "static const unsigned char scan_follows_operator[256] = {");
+    for (int c = 0; c < 256; c++) {
+        fprintf(out, "%s%d%s", c % 32 == 0 ? "\n    " : "", follows_operator[c], c != 255 ? "," : "");
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "#define SCAN_OP_CLASSES %d\n\n", num_op_classes);
+    fprintf(out, "/* Input byte -> operator class, 0 for bytes that occur in no operator */\n");
+    fprintf(out, "static const unsigned char scan_op_class[256] = {");
+    for (int c = 0; c < 256; c++) {
+        fprintf(out, "%s%d%s", c % 16 == 0 ? "\n    " : "", op_class[c], c != 255 ? ", " : "");
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "/* Operator classes of the next three bytes, as (a * SCAN_OP_CLASSES + b) * SCAN_OP_CLASSES\n"
+                 " * + c -> rule of the longest operator there + 1, 0 when no operator starts there (a lone &\n"
+                 " * is a special character, a / followed by a * opens a comment) */\n");
+    fprintf(out, "static const unsigned char scan_op[%d] = {",
+            num_op_classes * num_op_classes * num_op_classes);
+    int index = 0;
+    for (int a = 0; a < num_op_classes; a++) {
+        for (int b = 0; b < num_op_classes; b++) {
+            for (int c = 0; c < num_op_classes; c++) {
+                fprintf(out, "%s%d%s", index % 24 == 0 ? "\n    " : "",
+                        operator_entry(op_representative, a, b, c),
+                        index != num_op_classes * num_op_classes * num_op_classes - 1 ? "," : "");
+                index++;
+            }
+        }
+    }
+    fprintf(out, "\n};\n\n#endif /* SCANNER_TABLES_H */\n");
+    fclose(out);
+    return 0;
+}